@@ -0,0 +1,40 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 10000
+
+# File is encoded as UTF-8
+STRING = "Äffin"
+STRING_UTF16 = STRING.encode('UTF-16LE')
+
+def report(name)
+  GC.start
+  GC.disable
+  objects = GC.stat(:total_allocated_objects)
+  malloc = GC.stat(:malloc_increase_bytes)
+  realtime = Benchmark.realtime { RUN.times { yield } }
+  objects = GC.stat(:total_allocated_objects) - objects
+  malloc = GC.stat(:malloc_increase_bytes) - malloc
+  GC.enable
+  puts format('%-40s %10.2f %14.1f %10.3f', name, objects.to_f / RUN, malloc.to_f / RUN, realtime)
+end
+
+puts "", "Allocations per call", ""
+puts format('%-40s %10s %14s %10s', '', 'objects', 'malloc bytes', 'real (s)')
+
+normalizer = ICU::Normalizer.new(:nfc, :decompose)
+report('Normalizer#normalize UTF-8') { normalizer.normalize(STRING) }
+report('Normalizer#normalize UTF-16') { normalizer.normalize(STRING_UTF16) }
+report('Normalizer#normalized? UTF-8') { normalizer.normalized?(STRING) }
+
+collator = ICU::Collator.new('de')
+report('Collator#compare UTF-16') { collator.compare(STRING_UTF16, STRING_UTF16) }
+report('Collator#sort_key UTF-8') { collator.sort_key(STRING) }
+
+transliterator = ICU::Transliterator.new('Any-Latin')
+report('Transliterator#transliterate UTF-8') { transliterator.transliterate(STRING) }
+
+spoof_checker = ICU::SpoofChecker.new
+report('SpoofChecker#get_skeleton UTF-8') { spoof_checker.get_skeleton(STRING) }
+report('SpoofChecker#confusable? UTF-8') { spoof_checker.confusable?(STRING, STRING) }
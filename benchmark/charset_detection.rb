@@ -0,0 +1,27 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+ENCODINGS = %w(UTF-8 UTF-16BE ISO-8859-1 Shift_JIS).freeze
+
+# File is encoded as UTF-8
+LINES = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').lines.map(&:chomp)
+# small uploads in a few encodings, as binary like data read from a socket
+BLOBS = LINES.each_with_index.map do |line, i|
+  line.encode(ENCODINGS[i % ENCODINGS.size], invalid: :replace, undef: :replace).force_encoding('binary')
+end.freeze
+DETECTOR = ICU::CharsetDetector.new
+
+puts "", "Detect #{BLOBS.size} small blobs benchmark", ""
+
+LABELS = %w(detect detect_name detect_many).freeze
+TIMES = Benchmark.bmbm do |x|
+  x.report(LABELS[0]) { BLOBS.each { |blob| DETECTOR.detect(blob) } }
+  x.report(LABELS[1]) { BLOBS.each { |blob| DETECTOR.detect_name(blob) } }
+  x.report(LABELS[2]) { DETECTOR.detect_many(BLOBS) }
+end
+
+puts "", "Detections per second", ""
+LABELS.zip(TIMES).each do |label, tms|
+  puts format('%-12s %10.0f', label, BLOBS.size / tms.real)
+end
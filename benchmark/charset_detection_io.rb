@@ -0,0 +1,30 @@
+require 'rubygems'
+require 'benchmark'
+require 'tempfile'
+require 'icu'
+
+SIZES_MB = [1, 16, 64].freeze
+
+# File is encoded as UTF-8
+TEXT = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8')
+DETECTOR = ICU::CharsetDetector.new
+
+SIZES_MB.each do |size_mb|
+  file = Tempfile.new(['charset_detection', '.txt'])
+  file.binmode
+  file.write(TEXT) while file.size < size_mb * 1024 * 1024
+  file.flush
+
+  puts "", "Detect the charset of a #{size_mb} MB file benchmark", ""
+
+  Benchmark.bmbm do |x|
+    x.report('read and detect') { DETECTOR.detect(File.binread(file.path)) }
+    ICU::CharsetDetector::IO_STRATEGIES.each do |strategy|
+      x.report("detect_io #{strategy}") do
+        File.open(file.path, 'rb') { |io| DETECTOR.detect_io(io, strategy: strategy) }
+      end
+    end
+  end
+
+  file.close!
+end
@@ -0,0 +1,27 @@
+require 'rubygems'
+require 'benchmark'
+require 'stringio'
+require 'icu'
+
+RUN = 20
+
+# File is encoded as UTF-8
+TEXT = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8')
+LATIN = TEXT.encode('ISO-8859-1', invalid: :replace, undef: :replace).force_encoding('binary')
+UTF16 = TEXT.encode('UTF-16').force_encoding('binary')
+DETECTOR = ICU::CharsetDetector.new
+
+def three_steps(detector, data)
+  name = detector.detect(data).name
+  data.dup.force_encoding(name).encode('UTF-8')
+end
+
+{'ISO-8859-1' => LATIN, 'UTF-16' => UTF16}.each do |label, data|
+  puts "", "Detect and convert #{data.bytesize / 1024} KB of #{label} to UTF-8 benchmark", ""
+
+  Benchmark.bmbm do |x|
+    x.report('detect, force_encoding, encode') { RUN.times { three_steps(DETECTOR, data) } }
+    x.report('ICU to_utf8') { RUN.times { DETECTOR.to_utf8(data) } }
+    x.report('ICU to_utf8_stream') { RUN.times { DETECTOR.to_utf8_stream(StringIO.new(data), StringIO.new) } }
+  end
+end
@@ -0,0 +1,71 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+SORT_RUN = 10
+
+# File is encoded as UTF-8
+WORDS = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').split
+WORDS_UTF16 = WORDS.map { |word| word.encode('UTF-16') }
+
+puts "", "Sort #{WORDS.size} words benchmark", ""
+
+Benchmark.bmbm do |x|
+  collator = ICU::Collator.new('nb')
+
+  x.report 'ICU collator compare block' do
+    SORT_RUN.times do
+      WORDS.sort { |a, b| collator.compare(a, b) }
+    end
+  end
+
+  x.report 'ICU collator sort_by sort_key' do
+    SORT_RUN.times do
+      WORDS.sort_by { |word| collator.sort_key(word) }
+    end
+  end
+
+  x.report 'ICU collator sort' do
+    SORT_RUN.times do
+      collator.sort(WORDS)
+    end
+  end
+end
+
+puts "", "Sort #{WORDS_UTF16.size} UTF-16 words benchmark", ""
+
+Benchmark.bmbm do |x|
+  collator = ICU::Collator.new('nb')
+
+  x.report 'ICU collator compare block' do
+    SORT_RUN.times do
+      WORDS_UTF16.sort { |a, b| collator.compare(a, b) }
+    end
+  end
+
+  x.report 'ICU collator sort' do
+    SORT_RUN.times do
+      collator.sort(WORDS_UTF16)
+    end
+  end
+end
+
+LONG_PHRASES = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').split("\n").map { |phrase| phrase * 20 }
+
+puts "", "Sort keys of #{LONG_PHRASES.size} long phrases benchmark", ""
+
+Benchmark.bmbm do |x|
+  collator = ICU::Collator.new('nb')
+
+  x.report 'ICU collator sort_key' do
+    SORT_RUN.times { LONG_PHRASES.each { |phrase| collator.sort_key(phrase) } }
+  end
+
+  x.report 'ICU collator sort_key max_bytes: 32' do
+    SORT_RUN.times { LONG_PHRASES.each { |phrase| collator.sort_key(phrase, max_bytes: 32) } }
+  end
+
+  x.report 'ICU collator sort_key levels: 1' do
+    SORT_RUN.times { LONG_PHRASES.each { |phrase| collator.sort_key(phrase, levels: 1) } }
+  end
+end
@@ -0,0 +1,36 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+# File is encoded as UTF-8
+WORDS = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').split
+VARIANTS = WORDS.flat_map { |word| [word, word.upcase, word.capitalize] }.shuffle(random: Random.new(42))
+SMALL = VARIANTS.first(1000)
+
+COLLATOR = ICU::Collator.new('nb')
+COLLATOR.strength = :primary
+
+def pairwise_groups(collator, strings)
+  groups = []
+  strings.each do |str|
+    group = groups.find { |g| collator.compare(g.first, str).zero? }
+    group ? group << str : groups << [str]
+  end
+  groups
+end
+
+puts "", "Group #{SMALL.size} strings case-insensitively benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('pairwise compare') { pairwise_groups(COLLATOR, SMALL) }
+  x.report('group_by sort_key') { SMALL.group_by { |str| COLLATOR.sort_key(str) } }
+  x.report('group_by hash_key') { SMALL.group_by { |str| COLLATOR.hash_key(str) } }
+  x.report('ICU collator group_by') { COLLATOR.group_by(SMALL) }
+end
+
+puts "", "Group #{VARIANTS.size} strings case-insensitively benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('group_by sort_key') { VARIANTS.group_by { |str| COLLATOR.sort_key(str) } }
+  x.report('ICU collator group_by') { COLLATOR.group_by(VARIANTS) }
+end
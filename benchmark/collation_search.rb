@@ -0,0 +1,55 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 10
+
+# File is encoded as UTF-8
+WORDS = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').split.uniq
+COLLATOR = ICU::Collator.new('nb')
+SORTED = COLLATOR.sort(WORDS)
+NEEDLES = WORDS.shuffle(random: Random.new(42))
+HALF_A, HALF_B = SORTED.partition.with_index { |_, i| i.even? }
+
+def ruby_merge(collator, a, b)
+  result = []
+  i = j = 0
+  while i < a.size && j < b.size
+    if collator.compare(b[j], a[i]) < 0
+      result << b[j]
+      j += 1
+    else
+      result << a[i]
+      i += 1
+    end
+  end
+  result.concat(a[i..-1]).concat(b[j..-1])
+end
+
+puts "", "Search #{NEEDLES.size} words in #{SORTED.size} sorted words benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report 'Array#bsearch_index with compare' do
+    RUN.times { NEEDLES.each { |needle| SORTED.bsearch_index { |str| COLLATOR.compare(str, needle) >= 0 } } }
+  end
+
+  x.report 'ICU collator bsearch_index' do
+    RUN.times { NEEDLES.each { |needle| COLLATOR.bsearch_index(SORTED, needle) } }
+  end
+end
+
+puts "", "Merge two sorted halves of #{SORTED.size} words benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report 'Ruby merge with compare' do
+    RUN.times { ruby_merge(COLLATOR, HALF_A, HALF_B) }
+  end
+
+  x.report 'ICU collator sort of both' do
+    RUN.times { COLLATOR.sort(HALF_A + HALF_B) }
+  end
+
+  x.report 'ICU collator merge' do
+    RUN.times { COLLATOR.merge(HALF_A, HALF_B) }
+  end
+end
@@ -0,0 +1,41 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 50
+
+# File is encoded as UTF-8
+PHRASES = File.read(File.expand_path('../normalization_phrases.txt', __FILE__), encoding: 'UTF-8').split("\n")
+
+COLLATORS = {
+  'identical' => ->(c) { c.strength = :identical },
+  'tertiary (default)' => ->(c) { c.strength = :tertiary },
+  'secondary' => ->(c) { c.strength = :secondary },
+  'primary' => ->(c) { c.strength = :primary },
+  'primary, no normalization' => ->(c) { c.strength = :primary; c.normalization = false },
+  'primary, shifted' => ->(c) { c.strength = :primary; c.alternate = :shifted },
+}.map do |name, configure|
+  collator = ICU::Collator.new('en')
+  configure.call(collator)
+  [name, collator]
+end
+
+puts "", "Compare adjacent #{PHRASES.size} phrases benchmark", ""
+
+Benchmark.bmbm do |x|
+  COLLATORS.each do |name, collator|
+    x.report("compare #{name}") do
+      RUN.times { PHRASES.each_cons(2) { |a, b| collator.compare(a, b) } }
+    end
+  end
+end
+
+puts "", "Sort and dedup #{PHRASES.size} phrases benchmark", ""
+
+Benchmark.bmbm do |x|
+  COLLATORS.each do |name, collator|
+    x.report("sort #{name}") do
+      RUN.times { collator.sort(PHRASES).chunk_while { |a, b| collator.compare(a, b).zero? }.map(&:first) }
+    end
+  end
+end
@@ -0,0 +1,25 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 10000
+
+LOCALES = %w(zh ja de nb ar)
+
+# File is encoded as UTF-8
+WORDS = %w(å ø æ)
+
+LOCALES.each do |locale|
+  puts "", "#{locale} collator", ""
+
+  Benchmark.bmbm do |x|
+    x.report('Collator.new') { RUN.times { ICU::Collator.new(locale) } }
+    x.report('Collator.for') { RUN.times { ICU::Collator.for(locale) } }
+    x.report('Collator.new per thread') do
+      4.times.map { Thread.new { (RUN / 4).times { ICU::Collator.new(locale).sort(WORDS) } } }.each(&:join)
+    end
+    x.report('Collator.for per thread') do
+      4.times.map { Thread.new { (RUN / 4).times { ICU::Collator.for(locale).sort(WORDS) } } }.each(&:join)
+    end
+  end
+end
@@ -0,0 +1,56 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+STRING_RUN = 100000
+
+# File is encoded as UTF-8
+STRING = "東京都渋谷区"
+STRINGS = {
+  'UTF-8' => STRING,
+  'Shift_JIS' => STRING.encode('Shift_JIS'),
+  'EUC-JP' => STRING.encode('EUC-JP'),
+  'UTF-16LE' => STRING.encode('UTF-16LE')
+}
+
+puts "", "Short string normalization by encoding benchmark", ""
+
+Benchmark.bmbm do |x|
+  icu_normalizer = ICU::Normalizer.new(name = :nfc, mode = :decompose)
+
+  STRINGS.each do |encoding, string|
+    x.report "ICU normalizer nfd #{encoding}" do
+      STRING_RUN.times do
+        icu_normalizer.normalize(string)
+      end
+    end
+  end
+end
+
+puts "", "Short string comparison by encoding benchmark", ""
+
+Benchmark.bmbm do |x|
+  icu_collator = ICU::Collator.new('ja')
+
+  STRINGS.each do |encoding, string|
+    x.report "ICU collator compare #{encoding}" do
+      STRING_RUN.times do
+        icu_collator.compare(string, string)
+      end
+    end
+  end
+end
+
+puts "", "Short string transliteration by encoding benchmark", ""
+
+Benchmark.bmbm do |x|
+  icu_transliterator = ICU::Transliterator.new('Katakana-Hiragana')
+
+  STRINGS.each do |encoding, string|
+    x.report "ICU transliterator #{encoding}" do
+      STRING_RUN.times do
+        icu_transliterator.transliterate(string)
+      end
+    end
+  end
+end
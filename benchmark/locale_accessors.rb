@@ -0,0 +1,64 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 2_000
+
+# Accept-Language headers of incoming requests
+HEADERS = [
+  "en-US,en;q=0.9",
+  "de-CH,de;q=0.8,fr;q=0.6,en;q=0.4",
+  "zh-Hant-TW,zh-TW;q=0.9,zh;q=0.8,en-US;q=0.7",
+  "pt-BR,pt;q=0.9,es;q=0.5",
+  "sr-Latn-RS,sr;q=0.8,hr;q=0.6",
+].freeze
+
+SUPPORTED = %w(en_US en_GB de_DE fr_FR pt_BR pt_PT es_ES zh_Hans_CN zh_Hant_TW sr_Latn_RS ja_JP).map { |id| ICU::Locale.new(id) }.freeze
+CANDIDATES = HEADERS.map { |header| header.split(",").map { |part| ICU::Locale.for_language_tag(part.split(";").first) } }.freeze
+
+# picks the supported locale matching the most components of the first acceptable candidate
+def negotiate(candidates)
+  candidates.each do |candidate|
+    language = candidate.language
+    matches = SUPPORTED.select { |locale| locale.language == language }
+    next if matches.empty?
+    return matches.find { |locale| locale.base_name == candidate.base_name } ||
+           matches.find { |locale| locale.script == candidate.with_likely_subtags.script && locale.country == candidate.country } ||
+           matches.find { |locale| locale.script == candidate.with_likely_subtags.script } ||
+           matches.first
+  end
+  SUPPORTED.first
+end
+
+puts "", "Negotiate #{HEADERS.size} Accept-Language headers against #{SUPPORTED.size} locales benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('parse headers per request') do
+    RUN.times do
+      HEADERS.each do |header|
+        negotiate(header.split(",").map { |part| ICU::Locale.for_language_tag(part.split(";").first) })
+      end
+    end
+  end
+  x.report('reuse parsed candidates') { RUN.times { CANDIDATES.each { |candidates| negotiate(candidates) } } }
+end
+
+puts "", "Read the components of #{SUPPORTED.size} locales benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('new locales') do
+    RUN.times do
+      SUPPORTED.each do |locale|
+        fresh = ICU::Locale.new(locale.id)
+        [fresh.language, fresh.country, fresh.script, fresh.base_name, fresh.language_tag, fresh.parent]
+      end
+    end
+  end
+  x.report('same locales') do
+    RUN.times do
+      SUPPORTED.each do |locale|
+        [locale.language, locale.country, locale.script, locale.base_name, locale.language_tag, locale.parent]
+      end
+    end
+  end
+end
@@ -104,3 +104,123 @@ Benchmark.bmbm do |x|
     end
   end
 end
+
+puts "", "UTF-8 path against the transcoding path", ""
+
+Benchmark.bmbm do |x|
+  icu_normalizer = ICU::Normalizer.new(name = :nfc, mode = :decompose)
+  string_utf16 = STRING.encode('UTF-16LE')
+  phrases_utf16 = PHRASES.encode('UTF-16LE')
+  text_utf16 = TEXT.encode('UTF-16LE')
+
+  x.report 'ICU normalizer nfd string UTF-8' do
+    STRING_RUN.times do
+      icu_normalizer.normalize(STRING)
+    end
+  end
+
+  x.report 'ICU normalizer nfd string UTF-16' do
+    STRING_RUN.times do
+      icu_normalizer.normalize(string_utf16)
+    end
+  end
+
+  x.report 'ICU normalizer nfd phrases UTF-8' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalize(PHRASES)
+    end
+  end
+
+  x.report 'ICU normalizer nfd phrases UTF-16' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalize(phrases_utf16)
+    end
+  end
+
+  x.report 'ICU normalizer nfd article UTF-8' do
+    TEXT_RUN.times do
+      icu_normalizer.normalize(TEXT)
+    end
+  end
+
+  x.report 'ICU normalizer nfd article UTF-16' do
+    TEXT_RUN.times do
+      icu_normalizer.normalize(text_utf16)
+    end
+  end
+end
+
+puts "", "Already normalized benchmark", ""
+
+Benchmark.bmbm do |x|
+  icu_normalizer = ICU::Normalizer.new(name = :nfc, mode = :compose)
+  phrases_nfc = icu_normalizer.normalize(PHRASES)
+  text_nfc = icu_normalizer.normalize(TEXT)
+
+  x.report 'ICU normalizer nfc phrases' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalize(phrases_nfc)
+    end
+  end
+
+  x.report 'ICU normalized? phrases' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalized?(phrases_nfc)
+    end
+  end
+
+  x.report 'Ruby stdlib normalizer phrases' do
+    PHRASES_RUN.times do
+      phrases_nfc.unicode_normalize(:nfc)
+    end
+  end
+
+  x.report 'ICU normalizer nfc article' do
+    TEXT_RUN.times do
+      icu_normalizer.normalize(text_nfc)
+    end
+  end
+
+  x.report 'ICU normalized? article' do
+    TEXT_RUN.times do
+      icu_normalizer.normalized?(text_nfc)
+    end
+  end
+
+  x.report 'Ruby stdlib normalizer article' do
+    TEXT_RUN.times do
+      text_nfc.unicode_normalize(:nfc)
+    end
+  end
+end
+
+puts "", "Phrases by line benchmark", ""
+
+Benchmark.bmbm do |x|
+  icu_normalizer = ICU::Normalizer.new(name = :nfc, mode = :decompose)
+  lines = PHRASES.lines
+
+  x.report 'ICU normalizer nfd' do
+    PHRASES_RUN.times do
+      lines.map { |line| icu_normalizer.normalize(line) }
+    end
+  end
+
+  x.report 'ICU normalizer nfd normalize_all' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalize_all(lines)
+    end
+  end
+
+  x.report 'ICU normalizer nfd normalize_all without GVL' do
+    PHRASES_RUN.times do
+      icu_normalizer.normalize_all(lines, without_gvl: true)
+    end
+  end
+
+  x.report 'Ruby stdlib normalizer' do
+    PHRASES_RUN.times do
+      lines.map { |line| line.unicode_normalize(:nfd) }
+    end
+  end
+end
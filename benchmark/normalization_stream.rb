@@ -0,0 +1,51 @@
+require 'rubygems'
+require 'benchmark'
+require 'tempfile'
+require 'icu'
+
+# Peak RSS is read from /proc, so this benchmark runs on Linux only.
+SIZES_MB = [8, 32, 128]
+
+TEXT = File.read(File.expand_path('../normalization_wikip.txt', __FILE__), encoding: 'UTF-8')
+
+def peak_rss_kb
+  File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+end
+
+# Runs in a child so every measurement starts with a fresh peak.
+def measure
+  reader, writer = IO.pipe
+  pid = fork do
+    reader.close
+    realtime = Benchmark.realtime { yield }
+    writer.puts "#{realtime} #{peak_rss_kb}"
+  end
+  writer.close
+  Process.wait(pid)
+  reader.read.split.map(&:to_f)
+end
+
+puts "", "Stream normalization benchmark", ""
+puts format('%-10s %-28s %12s %16s', 'size', 'method', 'real (s)', 'peak RSS (MB)')
+
+SIZES_MB.each do |size_mb|
+  Tempfile.create(['normalization', '.txt']) do |file|
+    (size_mb * 1024 * 1024 / TEXT.bytesize).times { file.write(TEXT) }
+    file.flush
+
+    {
+      'normalize(File.read)' => lambda do |normalizer|
+        File.open(File::NULL, 'w') { |out| out.write(normalizer.normalize(File.read(file.path, encoding: 'UTF-8'))) }
+      end,
+      'normalize_stream' => lambda do |normalizer|
+        File.open(file.path, 'r:UTF-8') do |input|
+          File.open(File::NULL, 'w') { |out| normalizer.normalize_stream(input, out) }
+        end
+      end
+    }.each do |name, job|
+      normalizer = ICU::Normalizer.new(:nfc, :decompose)
+      realtime, rss = measure { job.call(normalizer) }
+      puts format('%-10s %-28s %12.3f %16.1f', "#{size_mb} MB", name, realtime, rss / 1024)
+    end
+  end
+end
@@ -0,0 +1,27 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 200
+
+# File is encoded as UTF-8
+HANGUL = "한국어" * 10_000 # NFD is three times as long
+LATIN = "abcde" * 10_000 # Any-Hex is six times as long
+MIXED = "Äffin ﬁnancial пример " * 1_000
+
+normalizer = ICU::Normalizer.new(:nfc, :decompose)
+transliterator = ICU::Transliterator.new('Any-Hex')
+spoof_checker = ICU::SpoofChecker.new
+collator = ICU::Collator.new('de')
+words = MIXED.split(' ') * 100
+
+ICU.reset_retry_counts
+Benchmark.bmbm do |x|
+  x.report('Normalizer#normalize expanding') { RUN.times { normalizer.normalize(HANGUL) } }
+  x.report('Transliterator#transliterate expanding') { RUN.times { transliterator.transliterate(LATIN) } }
+  x.report('SpoofChecker#get_skeleton') { RUN.times { spoof_checker.get_skeleton(MIXED) } }
+  x.report('Collator#sort') { collator.sort(words) }
+end
+
+puts "", "Retries", ""
+ICU.retry_counts.each { |site, count| puts format('%-40s %10d', site, count) }
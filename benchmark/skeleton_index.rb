@@ -0,0 +1,43 @@
+require 'rubygems'
+require 'benchmark'
+require 'tmpdir'
+require 'icu'
+
+SIZES = (ENV['SIZES'] || '1000000,10000000').split(',').map(&:to_i)
+BATCH = 100_000
+LOOKUPS = 100_000
+
+CHECKER = ICU::SpoofChecker.new
+# handles in the shape of usernames, the lookups swap in a few confusable letters
+def handle(i)
+  "user_#{i.to_s(36)}_#{(i * 7919 % 1000).to_s.rjust(3, '0')}"
+end
+QUERIES = LOOKUPS.times.map { |i| handle(i * 97).tr('aeo', 'аеο') }
+
+puts "", "Check 100 queries against 10000 names pairwise benchmark", ""
+
+PAIRWISE = 10_000.times.map { |i| handle(i) }
+Benchmark.bm(24) do |x|
+  x.report('confusable? each pair') do
+    QUERIES.first(100).each { |query| PAIRWISE.any? { |name| CHECKER.confusable?(query, name) > 0 } }
+  end
+end
+
+SIZES.each do |size|
+  index = ICU::SpoofChecker::SkeletonIndex.new(CHECKER)
+  path = File.join(Dir.tmpdir, "skeleton_index_#{size}.bin")
+
+  puts "", "Skeleton index of #{size} names benchmark", ""
+
+  Benchmark.bm(24) do |x|
+    x.report('build') do
+      (0...size).step(BATCH) { |from| index.concat((from...[from + BATCH, size].min).map { |i| handle(i) }) }
+    end
+    lookups = x.report("#{LOOKUPS} lookups") { QUERIES.each { |query| index.lookup(query) } }
+    x.report('save') { index.save(path) }
+    x.report('load') { ICU::SpoofChecker::SkeletonIndex.load(path, CHECKER) }
+    puts format('%.0f lookups per second, %d MB file', LOOKUPS / lookups.real, File.size(path) / 1024 / 1024)
+  end
+
+  File.delete(path)
+end
@@ -0,0 +1,42 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 20
+
+# signup handles, some of them mixing scripts or numbering systems
+HANDLES = 10_000.times.map do |i|
+  case i % 4
+  when 0 then "user#{i}"
+  when 1 then "usеr#{i}"
+  when 2 then "user#{i}٣"
+  else "ユーザー#{i}"
+  end
+end.freeze
+
+CHECKER = ICU::SpoofChecker.new
+CHECKS = ICU::SpoofChecker.available_checks
+LEVEL_ONLY = ICU::SpoofChecker.new.tap { |checker| checker.checks = CHECKS[:restriction_level] | CHECKS[:aux_info] }
+NUMBERS_ONLY = ICU::SpoofChecker.new.tap { |checker| checker.checks = CHECKS[:mixed_numbers] }
+
+puts "", "Check #{HANDLES.size} handles benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('check each') { RUN.times { HANDLES.each { |handle| CHECKER.check(handle) } } }
+  x.report('check_all') { RUN.times { CHECKER.check_all(HANDLES) } }
+end
+
+puts "", "Check #{HANDLES.size} handles with the restriction level and numerics benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('check with three checkers') do
+    RUN.times do
+      HANDLES.each do |handle|
+        CHECKER.check(handle)
+        LEVEL_ONLY.check(handle) & ICU::SpoofChecker.available_restriction_levels[:restriction_level_mask]
+        NUMBERS_ONLY.check(handle)
+      end
+    end
+  end
+  x.report('check_details') { RUN.times { HANDLES.each { |handle| CHECKER.check_details(handle) } } }
+end
@@ -0,0 +1,33 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 100000
+
+# File is encoded as UTF-8
+SHORT = "pаypаl_support"
+LONG = "𝔭𝒶ỿ𝕡𝕒ℓ " * 20
+SHORT_UTF16 = SHORT.encode('UTF-16LE')
+
+def report(name)
+  GC.start
+  GC.disable
+  objects = GC.stat(:total_allocated_objects)
+  malloc = GC.stat(:malloc_increase_bytes)
+  realtime = Benchmark.realtime { RUN.times { yield } }
+  objects = GC.stat(:total_allocated_objects) - objects
+  malloc = GC.stat(:malloc_increase_bytes) - malloc
+  GC.enable
+  puts format('%-40s %10.2f %14.1f %12.3f', name, objects.to_f / RUN, malloc.to_f / RUN, realtime * 1_000_000 / RUN)
+end
+
+puts "", "SpoofChecker allocations and latency per call", ""
+puts format('%-40s %10s %14s %12s', '', 'objects', 'malloc bytes', 'latency (µs)')
+
+checker = ICU::SpoofChecker.new
+report('get_skeleton short UTF-8') { checker.get_skeleton(SHORT) }
+report('get_skeleton long UTF-8') { checker.get_skeleton(LONG) }
+report('get_skeleton short UTF-16') { checker.get_skeleton(SHORT_UTF16) }
+report('confusable? short UTF-8') { checker.confusable?(SHORT, "paypal_support") }
+report('confusable? long UTF-8') { checker.confusable?(LONG, LONG) }
+report('confusable? short UTF-16') { checker.confusable?(SHORT_UTF16, SHORT_UTF16) }
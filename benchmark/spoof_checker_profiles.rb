@@ -0,0 +1,51 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+THREADS = Integer(ENV.fetch('THREADS', 8))
+REQUESTS = 2_000
+
+CHECKS = ICU::SpoofChecker.available_checks
+LEVELS = ICU::SpoofChecker.available_restriction_levels
+USERNAME_CHECKS = CHECKS[:restriction_level] | CHECKS[:mixed_numbers] | CHECKS[:invisible]
+
+HANDLES = 1_000.times.map { |i| i.even? ? "user#{i}" : "usеr#{i}" }.freeze
+
+ICU::SpoofChecker.profile(:username, checks: USERNAME_CHECKS,
+                                     level: LEVELS[:moderately_restrictive],
+                                     allowed_locales: %w(en ru))
+
+def in_threads
+  THREADS.times.map { Thread.new { REQUESTS.times { |i| yield HANDLES[i % HANDLES.size] } } }.each(&:join)
+end
+
+puts "", "Check #{THREADS * REQUESTS} usernames from #{THREADS} threads benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report('new and configure per request') do
+    in_threads do |handle|
+      checker = ICU::SpoofChecker.new
+      checker.checks = USERNAME_CHECKS
+      checker.restriction_level = LEVELS[:moderately_restrictive]
+      checker.allowed_locales = %w(en ru)
+      checker.check(handle)
+    end
+  end
+  x.report('profile') { in_threads { |handle| ICU::SpoofChecker.profile(:username).check(handle) } }
+end
+
+if defined?(Ractor)
+  puts "", "Check #{THREADS * REQUESTS} usernames from #{THREADS} Ractors benchmark", ""
+
+  Warning[:experimental] = false
+  profile = ICU::SpoofChecker.profile(:username)
+  Benchmark.bm(30) do |x|
+    x.report('shared profile') do
+      THREADS.times.map do
+        Ractor.new(profile, HANDLES) do |checker, handles|
+          REQUESTS.times { |i| checker.check(handles[i % handles.size]) }
+        end
+      end.each(&:take)
+    end
+  end
+end
@@ -0,0 +1,40 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 20
+
+# File is encoded as UTF-8
+LINES = File.read(File.expand_path('../normalization_wikip.txt', __FILE__), encoding: 'UTF-8').lines
+PATTERNS = %w(braille wikipedia louis).freeze
+
+COLLATOR = ICU::Collator.new('en')
+COLLATOR.strength = :primary
+NORMALIZER = ICU::Normalizer.new(:nfkc, :decompose)
+
+# the usual workaround: fold both sides, then a regexp over the folded text
+def fold(str)
+  NORMALIZER.normalize(str).gsub(/\p{Mn}/, '').downcase
+end
+
+puts "", "Search #{PATTERNS.size} patterns in #{LINES.size} lines ignoring accents and case benchmark", ""
+
+Benchmark.bmbm do |x|
+  x.report 'fold and Regexp' do
+    RUN.times do
+      PATTERNS.each do |pattern|
+        regexp = Regexp.new(Regexp.escape(fold(pattern)))
+        LINES.each { |line| fold(line).scan(regexp).size }
+      end
+    end
+  end
+
+  x.report 'ICU StringSearch' do
+    RUN.times do
+      PATTERNS.each do |pattern|
+        search = ICU::StringSearch.new(pattern, COLLATOR)
+        LINES.each { |line| search.each_match(line) { } }
+      end
+    end
+  end
+end
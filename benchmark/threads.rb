@@ -0,0 +1,38 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+THREADS = [1, 2, 4, 8]
+TEXT_RUN = 32
+
+# File is encoded as UTF-8, large enough to be processed without the GVL
+TEXT = File.read(File.expand_path('../normalization_wikip.txt', __FILE__), encoding: 'UTF-8')
+TEXT_SHORT = TEXT[0, 100_000]
+
+def run_threaded(threads, runs)
+  per_thread = runs / threads
+  threads.times.map do
+    Thread.new do
+      per_thread.times { yield }
+    end
+  end.each(&:join)
+end
+
+def report(title, &block)
+  puts "", title, ""
+  Benchmark.bm(10) do |x|
+    THREADS.each do |threads|
+      x.report("#{threads} thread#{threads > 1 ? 's' : ''}") do
+        run_threaded(threads, TEXT_RUN, &block)
+      end
+    end
+  end
+end
+
+normalizer = ICU::Normalizer.new(:nfc, :decompose)
+report("Article normalization, #{TEXT_RUN} runs in total") { normalizer.normalize(TEXT) }
+
+transliterator = ICU::Transliterator.new('Any-Latin')
+report("Transliteration, #{TEXT_RUN} runs in total") { transliterator.transliterate(TEXT_SHORT) }
+
+report("Charset detection, #{TEXT_RUN} runs in total") { ICU::CharsetDetector.new.detect_all(TEXT) }
@@ -0,0 +1,69 @@
+require 'rubygems'
+require 'benchmark'
+require 'tempfile'
+require 'icu'
+
+# Peak RSS is read from /proc, so this benchmark runs on Linux only.
+SIZES_MB = [1, 2]
+TRANSLITERATOR_ID = 'Any-Latin; Latin-ASCII'
+
+# File is encoded as UTF-8
+LINES = [
+  "[12:00:01] anna: Привет! Как дела? Сегодня встреча в 15:00.\n",
+  "[12:00:07] kenji: 了解しました、資料を送ります。\n",
+  "[12:00:12] nikos: Καλημέρα σε όλους, τα λέμε αύριο.\n",
+  "[12:00:20] bob: ok, see you there\n",
+  "[12:00:31] li: 我们明天下午开会，请准时参加。\n",
+]
+
+def peak_rss_kb
+  File.read('/proc/self/status')[/VmHWM:\s+(\d+)/, 1].to_i
+end
+
+# Runs in a child so every measurement starts with a fresh peak.
+def measure
+  reader, writer = IO.pipe
+  pid = fork do
+    reader.close
+    realtime = Benchmark.realtime { yield }
+    writer.puts "#{realtime} #{peak_rss_kb}"
+  end
+  writer.close
+  Process.wait(pid)
+  reader.read.split.map(&:to_f)
+end
+
+puts "", "Stream transliteration benchmark (#{TRANSLITERATOR_ID})", ""
+puts format('%-10s %-32s %12s %16s', 'size', 'method', 'real (s)', 'peak RSS (MB)')
+
+SIZES_MB.each do |size_mb|
+  Tempfile.create(['transliteration', '.txt']) do |file|
+    written = 0
+    while written < size_mb * 1024 * 1024
+      line = LINES.sample
+      file.write(line)
+      written += line.bytesize
+    end
+    file.flush
+
+    {
+      'transliterate(File.read)' => lambda do |transliterator|
+        File.open(File::NULL, 'w') { |out| out.write(transliterator.transliterate(File.read(file.path, encoding: 'UTF-8'))) }
+      end,
+      'transliterate by line' => lambda do |transliterator|
+        File.open(File::NULL, 'w') do |out|
+          File.foreach(file.path, encoding: 'UTF-8') { |line| out.write(transliterator.transliterate(line)) }
+        end
+      end,
+      'transliterate_stream' => lambda do |transliterator|
+        File.open(file.path, 'r:UTF-8') do |input|
+          File.open(File::NULL, 'w') { |out| transliterator.transliterate_stream(input, out) }
+        end
+      end
+    }.each do |name, job|
+      transliterator = ICU::Transliterator.new(TRANSLITERATOR_ID)
+      realtime, rss = measure { job.call(transliterator) }
+      puts format('%-10s %-32s %12.3f %16.1f', "#{size_mb} MB", name, realtime, rss / 1024)
+    end
+  end
+end
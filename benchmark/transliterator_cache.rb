@@ -0,0 +1,25 @@
+require 'rubygems'
+require 'benchmark'
+require 'icu'
+
+RUN = 200
+
+IDS = ['Any-Latin; Latin-ASCII', 'Greek-Latin', 'Han-Latin', 'NFD; [:Nonspacing Mark:] Remove; NFC']
+
+# File is encoded as UTF-8
+STRING = "Ελληνικά"
+
+Benchmark.bmbm do |x|
+  IDS.each do |id|
+    x.report("#{id} cold open") do
+      ICU::Transliterator.cache_size = 0
+      RUN.times { ICU::Transliterator.transliterate(id, STRING) }
+    end
+    x.report("#{id} cached clone") do
+      ICU::Transliterator.cache_size = 32
+      RUN.times { ICU::Transliterator.transliterate(id, STRING) }
+    end
+  end
+end
+
+puts "", ICU::Transliterator.cache_stats.inspect
@@ -250,5 +250,7 @@ have_func('u_init', 'unicode/uclean.h') ||
   have_library('libicui18n', 'u_init', 'unicode/uclean.h') or
   asplode('libicui18n')
 have_func('u_errorName')
+have_header('ruby/ractor.h')
+have_header('ruby/atomic.h')
 
 create_makefile('icu/icu')
@@ -7,12 +7,15 @@ void Init_icu(void)
     rb_mICU = rb_define_module("ICU");
     init_internal_encoding();
     init_rb_errors();
+    init_internal_utils();
     init_icu_collator();
     init_icu_normalizer();
     init_icu_spoof_checker();
+    init_icu_skeleton_index();
     init_icu_transliterator();
     init_icu_charset_detector();
     init_icu_locale();
+    init_icu_string_search();
 }
 
 /* vim: set expandtab sws=4 sw=4: */
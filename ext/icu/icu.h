@@ -1,20 +1,55 @@
 #ifndef RUBY_EXTENSION_ICU_H_
 #define RUBY_EXTENSION_ICU_H_
 
-/* System libraries */
-#include <stdlib.h>
-
-/* Ruby headers */
+/* Ruby headers, first so the feature macros of ruby/config.h (qsort_r of _GNU_SOURCE) apply */
 #define ONIG_ESCAPE_UCHAR_COLLISION 1  // ruby.h defines UChar macro
 #include <ruby.h>
 #include <ruby/encoding.h>
+#include <ruby/thread.h>
 #ifdef UChar // fail-safe
   #undef UChar
 #endif
+
+/* System libraries */
+#include <stdlib.h>
 #include "unicode/ustring.h"
 #include "unicode/uenum.h"
 #include "unicode/parseerr.h"
 
+/* Types */
+
+#define ICU_USCRATCH_INLINE_CAPA 128
+
+/* A transient UChar buffer living on the C stack, short strings use the inline storage
+   and longer ones a GC managed temporary buffer. Never copy it, ptr may point into it. */
+typedef struct {
+    UChar* ptr;
+    int32_t len;
+    int32_t capa;
+    VALUE heap;
+    UChar inline_ptr[ICU_USCRATCH_INLINE_CAPA];
+} icu_uscratch;
+
+/* Places where a too small output buffer makes ICU calls run again, see icu_count_retry */
+typedef enum {
+    ICU_RETRY_USTRING_FROM_RB_STR,
+    ICU_RETRY_NORMALIZE,
+    ICU_RETRY_SKELETON,
+    ICU_RETRY_SORT_KEY,
+    ICU_RETRY_SITES
+} icu_retry_site;
+
+/* The shared part of the methods reading io_in by chunks and writing to io_out, see
+   icu_stream_run. The state of a stream starts with it, so the callbacks can cast back. */
+typedef struct icu_stream {
+    VALUE io_in;
+    VALUE io_out;
+    long chunk_size;
+    size_t written; // bytes written to io_out
+    void (*process)(struct icu_stream*, VALUE); // gets every chunk and nil at the end of io_in
+    void (*close)(struct icu_stream*); // runs even when process raises
+} icu_stream;
+
 /* Globals */
 
 extern VALUE rb_mICU;
@@ -24,31 +59,51 @@ extern VALUE rb_cICU_UString;
 extern VALUE rb_cICU_Collator;
 extern VALUE rb_cICU_Normalizer;
 extern VALUE rb_cICU_SpoofChecker;
+extern VALUE rb_cICU_SpoofChecker_CheckResult;
+extern VALUE rb_cICU_SpoofChecker_SkeletonIndex;
 extern VALUE rb_cICU_Transliterator;
 extern VALUE rb_cICU_CharsetDetector;
 extern VALUE rb_cICU_CharsetDetector_Match;
 extern VALUE rb_cICU_Locale;
+extern VALUE rb_cICU_StringSearch;
 
 /* Prototypes */
 void Init_icu                                          _(( void ));
 void init_internal_encoding                            _(( void ));
 void init_rb_errors                                    _(( void ));
+void init_internal_utils                               _(( void ));
 void init_icu_collator                                 _(( void ));
 void init_icu_normalizer                               _(( void ));
 void init_icu_spoof_checker                            _(( void ));
+void init_icu_skeleton_index                           _(( void ));
 void init_icu_transliterator                           _(( void ));
 void init_icu_charset_detector                         _(( void ));
 void init_icu_locale                                   _(( void ));
+void init_icu_string_search                            _(( void ));
 
 int icu_is_rb_enc_idx_as_utf_8                         _(( int ));
 int icu_is_rb_str_as_utf_8                             _(( VALUE ));
 const char* icu_rb_str_enc_name                        _(( int ));
 VALUE rb_str_enc_to_ascii_as_utf8                      _(( VALUE ));
 int icu_rb_str_enc_idx                                 _(( VALUE ));
+struct UConverter* icu_converter_for_enc_idx           _(( int ));
+const char* icu_converter_name_for_enc_idx             _(( int ));
+struct UConverter* icu_converter_borrow                _(( const char* ));
+void icu_converter_give_back                           _(( const char*, struct UConverter* ));
+struct UCollator* icu_collator_service                 _(( VALUE ));
+const struct USpoofChecker* icu_spoof_checker_service  _(( VALUE ));
+int32_t icu_spoof_skeleton                             _(( const struct USpoofChecker*, const icu_uscratch*, icu_uscratch* ));
 VALUE icu_enum_to_rb_ary                               _(( UEnumeration*, UErrorCode, long ));
 extern void icu_rb_raise_icu_error                     _(( UErrorCode ));
 extern void icu_rb_raise_icu_parse_error               _(( const UParseError* ));
 extern void icu_rb_raise_icu_invalid_parameter         _(( const char*, const char* ));
+void icu_count_retry                                   _(( icu_retry_site ));
+void* icu_call_without_gvl_when                        _(( long, void* (*)(void*), void* ));
+void icu_call_without_gvl_resumable_when               _(( long, void* (*)(void*), void*, volatile int* ));
+void icu_stream_init                                   _(( icu_stream*, int, VALUE* ));
+int icu_stream_external_enc_idx                        _(( const icu_stream* ));
+void icu_stream_write                                  _(( icu_stream*, VALUE ));
+void icu_stream_run                                    _(( icu_stream* ));
 
 VALUE icu_ustring_init_with_capa_enc                   _(( int32_t, int ));
 VALUE icu_ustring_from_rb_str                          _(( VALUE ));
@@ -58,9 +113,15 @@ void icu_ustring_resize                                _(( VALUE, int32_t ));
 void icu_ustring_set_enc                               _(( VALUE, int ));
 VALUE icu_ustring_to_rb_enc_str_with_len               _(( VALUE, int32_t ));
 VALUE icu_ustring_to_rb_enc_str                        _(( VALUE ));
+VALUE icu_uchar_to_rb_enc_str                          _(( const UChar*, int32_t, int ));
+int32_t icu_rb_str_to_uchar                            _(( VALUE, UChar*, int32_t, UErrorCode* ));
 UChar* icu_ustring_ptr                                 _(( VALUE ));
 int32_t icu_ustring_len                                _(( VALUE ));
 int32_t icu_ustring_capa                               _(( VALUE ));
+void icu_uscratch_init                                _(( icu_uscratch*, int32_t ));
+void icu_uscratch_from_rb_str                          _(( icu_uscratch*, VALUE ));
+void icu_uscratch_resize                               _(( icu_uscratch*, int32_t ));
+void icu_uscratch_free                                 _(( icu_uscratch* ));
 VALUE char_buffer_to_rb_str                            _(( const char* ));
 char* char_buffer_new                                  _(( int32_t ));
 void char_buffer_resize                                _(( const char*, int32_t ));
@@ -68,6 +129,12 @@ void char_buffer_free                                  _(( const char* ));
 
 /* Constants */
 #define RUBY_C_STRING_TERMINATOR_SIZE 1
+// inputs at least this long are processed without holding the GVL
+#define ICU_WITHOUT_GVL_THRESHOLD 16384
+// the bytes read from io_in at once by the stream methods, unless they're told otherwise
+#define ICU_STREAM_CHUNK_SIZE 65536
+// leaves room for the doubled buffers of the chunks within the int32_t lengths of ICU
+#define ICU_STREAM_MAX_CHUNK_SIZE (INT32_MAX / 4)
 
 /* Macros */
 #define ICU_RUBY_ENCODING_INDEX (rb_enc_to_index(rb_default_internal_encoding()) || rb_locale_encindex())
@@ -1,5 +1,8 @@
 #include "icu.h"
 #include "unicode/ucsdet.h"
+#include "unicode/ucnv.h"
+#include "ruby/util.h"
+#include <string.h>
 
 #define GET_DETECTOR(_data) icu_detector_data* _data; \
                             TypedData_Get_Struct(self, icu_detector_data, &icu_detector_type, _data)
@@ -7,19 +10,34 @@
 VALUE rb_cICU_CharsetDetector;
 VALUE rb_cICU_CharsetDetector_Match;
 
+// UTF-16 units between the source and the UTF-8 converter
+#define DETECTOR_PIVOT_SIZE 1024
+
 typedef struct {
     VALUE rb_instance;
     UCharsetDetector* service;
-    char* dummy_str; // used for reset
+    UConverter* source; // converts from the charset last detected by to_utf8, source_name
+    char source_name[UCNV_MAX_CONVERTER_NAME_LENGTH];
+    UConverter* target; // converts to UTF-8
+    VALUE lock; // the service holds the text, detections can't run concurrently
 } icu_detector_data;
 
+static void detector_mark(void* _this)
+{
+    icu_detector_data* this = _this;
+    rb_gc_mark(this->lock);
+}
+
 static void detector_free(void* _this)
 {
     icu_detector_data* this = _this;
-    if (this->dummy_str != NULL) {
-        ruby_xfree(this->dummy_str);
-    }
     ucsdet_close(this->service);
+    if (this->source != NULL) {
+        ucnv_close(this->source);
+    }
+    if (this->target != NULL) {
+        ucnv_close(this->target);
+    }
 }
 
 static size_t detector_memsize(const void* _)
@@ -29,20 +47,45 @@ static size_t detector_memsize(const void* _)
 
 static const rb_data_type_t icu_detector_type = {
     "icu/charset_detector",
-    {NULL, detector_free, detector_memsize,},
+    {detector_mark, detector_free, detector_memsize,},
     0, 0,
     RUBY_TYPED_FREE_IMMEDIATELY,
 };
 
-static VALUE detector_populate_match_struct(const UCharsetMatch* match)
+/* Frozen charset and language names, keyed by the name, shared by every detector.
+   The table is process wide and unlocked, it is only touched with the GVL held and
+   CharsetDetector methods aren't marked Ractor safe, so only the main Ractor reaches it.
+   ICU knows a few dozen names, the marked strings never go away. */
+static st_table* detector_names = NULL;
+
+static VALUE detector_intern_name(const char* name)
+{
+    if (detector_names == NULL) {
+        detector_names = st_init_strtable();
+    }
+    st_data_t rb_name;
+    if (!st_lookup(detector_names, (st_data_t)name, &rb_name)) {
+        rb_name = (st_data_t)rb_obj_freeze(rb_str_new_cstr(name));
+        rb_gc_register_mark_object((VALUE)rb_name);
+        st_insert(detector_names, (st_data_t)ruby_strdup(name), rb_name);
+    }
+    return (VALUE)rb_name;
+}
+
+static VALUE detector_match_name(const UCharsetMatch* match)
 {
     UErrorCode status = U_ZERO_ERROR;
-    int32_t confidence = ucsdet_getConfidence(match, &status);
+    const char* name = ucsdet_getName(match, &status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
-    status = U_ZERO_ERROR;
-    const char* name = ucsdet_getName(match, &status);
+    return detector_intern_name(name);
+}
+
+static VALUE detector_populate_match_struct(const UCharsetMatch* match)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t confidence = ucsdet_getConfidence(match, &status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
@@ -52,9 +95,9 @@ static VALUE detector_populate_match_struct(const UCharsetMatch* match)
         icu_rb_raise_icu_error(status);
     }
     return rb_struct_new(rb_cICU_CharsetDetector_Match,
-                         rb_str_new_cstr(name),
+                         detector_match_name(match),
                          INT2NUM(confidence),
-                         rb_str_new_cstr(language));
+                         detector_intern_name(language));
 }
 
 VALUE detector_alloc(VALUE self)
@@ -68,55 +111,186 @@ VALUE detector_initialize(int argc, VALUE* argv, VALUE self)
     GET_DETECTOR(this);
     this->rb_instance = self;
     this->service = NULL;
+    this->source = NULL;
+    this->source_name[0] = '\0';
+    this->target = NULL;
 
     UErrorCode status = U_ZERO_ERROR;
     this->service = ucsdet_open(&status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
-    this->dummy_str = ALLOC_N(char, 1);
-    this->dummy_str[0] = '\0';
+    this->lock = rb_mutex_new();
 
     return self;
 }
 
-static inline void detector_reset_text(const icu_detector_data* this)
+static const char k_empty_source[] = "";
+
+// rb_str must be a ruby String.
+// The service points into rb_str until detector_reset_text, which every detection
+// calls once ICU is done with the text. An interrupt raised when the GVL comes back
+// skips it, which is harmless as the service only reads the text during a detection
+// and every detection sets its own text first.
+static inline void detector_set_text(const icu_detector_data* this, VALUE rb_str)
 {
     UErrorCode status = U_ZERO_ERROR;
-    ucsdet_setText(this->service, this->dummy_str, 0, &status);
+    ucsdet_setText(this->service, RSTRING_PTR(rb_str), RSTRING_LENINT(rb_str), &status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
 }
 
-// rb_str must be a ruby String
-static inline void detector_set_text(const icu_detector_data* this, VALUE rb_str)
+// rb_str may be modified or collected after the detection, the matches don't need the text
+static inline void detector_reset_text(const icu_detector_data* this)
 {
     UErrorCode status = U_ZERO_ERROR;
-    ucsdet_setText(this->service, RSTRING_PTR(rb_str), RSTRING_LENINT(rb_str), &status);
-    if (U_FAILURE(status)) {
-        icu_rb_raise_icu_error(status);
+    ucsdet_setText(this->service, k_empty_source, 0, &status);
+}
+
+typedef struct {
+    UCharsetDetector* service;
+    const UCharsetMatch* match;
+    const UCharsetMatch** matches;
+    int32_t len_matches;
+    UErrorCode status;
+} detector_detect_args;
+
+static void* detector_detect_nogvl(void* _args)
+{
+    detector_detect_args* args = _args;
+    args->match = ucsdet_detect(args->service, &args->status);
+    return NULL;
+}
+
+static void* detector_detect_all_nogvl(void* _args)
+{
+    detector_detect_args* args = _args;
+    args->matches = ucsdet_detectAll(args->service, &args->len_matches, &args->status);
+    return NULL;
+}
+
+typedef struct {
+    VALUE self;
+    VALUE str;
+} detector_locked_args;
+
+// str must stay unmodified while the GVL is released, see detector_detect
+static const UCharsetMatch* detector_detect_internal(const icu_detector_data* this, VALUE str)
+{
+    detector_set_text(this, str);
+    detector_detect_args args;
+    args.service = this->service;
+    args.status = U_ZERO_ERROR;
+    icu_call_without_gvl_when(RSTRING_LEN(str), detector_detect_nogvl, &args);
+    detector_reset_text(this);
+    if (U_FAILURE(args.status)) {
+        icu_rb_raise_icu_error(args.status);
     }
+    return args.match;
 }
 
-//
-// no charset appears to match the data.
-// no input text has been provided
-VALUE detector_detect(VALUE self, VALUE str)
+static VALUE detector_detect_locked(VALUE _args)
 {
-    StringValue(str);
+    detector_locked_args* locked_args = (detector_locked_args*)_args;
+    VALUE self = locked_args->self;
     GET_DETECTOR(this);
 
-    detector_set_text(this, str);
-    UErrorCode status = U_ZERO_ERROR;
-    const UCharsetMatch* match = ucsdet_detect(this->service, &status);
-    if (U_FAILURE(status)) {
-        icu_rb_raise_icu_error(status);
+    return detector_populate_match_struct(detector_detect_internal(this, locked_args->str));
+}
+
+static VALUE detector_detect_name_locked(VALUE _args)
+{
+    detector_locked_args* locked_args = (detector_locked_args*)_args;
+    VALUE self = locked_args->self;
+    GET_DETECTOR(this);
+
+    return detector_match_name(detector_detect_internal(this, locked_args->str));
+}
+
+// locked_args->str is the Array of Strings
+static VALUE detector_detect_many_locked(VALUE _args)
+{
+    detector_locked_args* locked_args = (detector_locked_args*)_args;
+    VALUE self = locked_args->self;
+    GET_DETECTOR(this);
+
+    VALUE ary = locked_args->str;
+    VALUE result = rb_ary_new2(RARRAY_LEN(ary));
+    for (long i = 0; i < RARRAY_LEN(ary); ++i) {
+        VALUE str = rb_ary_entry(ary, i);
+        StringValue(str);
+        if (RSTRING_LEN(str) >= ICU_WITHOUT_GVL_THRESHOLD) {
+            str = rb_str_new_frozen(str);
+        }
+        rb_ary_push(result, detector_populate_match_struct(detector_detect_internal(this, str)));
+        RB_GC_GUARD(str);
     }
+    return result;
+}
 
-    VALUE rb_match = detector_populate_match_struct(match);
+static VALUE detector_detect_all_locked(VALUE _args)
+{
+    detector_locked_args* locked_args = (detector_locked_args*)_args;
+    VALUE self = locked_args->self;
+    GET_DETECTOR(this);
+
+    detector_set_text(this, locked_args->str);
+    detector_detect_args args;
+    args.service = this->service;
+    args.len_matches = 0;
+    args.status = U_ZERO_ERROR;
+    icu_call_without_gvl_when(RSTRING_LEN(locked_args->str), detector_detect_all_nogvl, &args);
     detector_reset_text(this);
-    return rb_match;
+    if (U_FAILURE(args.status)) {
+        icu_rb_raise_icu_error(args.status);
+    }
+
+    VALUE result = rb_ary_new2(3); // pre-allocate some slots
+    for (int32_t i = 0; i < args.len_matches; ++i) {
+        rb_ary_push(result, detector_populate_match_struct(args.matches[i]));
+    }
+    return result;
+}
+
+VALUE detector_detect(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_DETECTOR(this);
+
+    detector_locked_args args;
+    args.self = self;
+    // frozen copy shares the buffer but can't be modified while the GVL is released
+    args.str = rb_str_new_frozen(str);
+    VALUE result = rb_mutex_synchronize(this->lock, detector_detect_locked, (VALUE)&args);
+    RB_GC_GUARD(args.str);
+    return result;
+}
+
+/* Detects only the name of the best matching charset, a frozen String. */
+VALUE detector_detect_name(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_DETECTOR(this);
+
+    detector_locked_args args;
+    args.self = self;
+    args.str = rb_str_new_frozen(str);
+    VALUE result = rb_mutex_synchronize(this->lock, detector_detect_name_locked, (VALUE)&args);
+    RB_GC_GUARD(args.str);
+    return result;
+}
+
+/* Detects the best match of every String in ary, taking the lock once for the batch. */
+VALUE detector_detect_many(VALUE self, VALUE ary)
+{
+    Check_Type(ary, T_ARRAY);
+    GET_DETECTOR(this);
+
+    detector_locked_args args;
+    args.self = self;
+    args.str = ary;
+    return rb_mutex_synchronize(this->lock, detector_detect_many_locked, (VALUE)&args);
 }
 
 VALUE detector_detect_all(VALUE self, VALUE str)
@@ -124,23 +298,235 @@ VALUE detector_detect_all(VALUE self, VALUE str)
     StringValue(str);
     GET_DETECTOR(this);
 
-    detector_set_text(this, str);
+    detector_locked_args args;
+    args.self = self;
+    args.str = rb_str_new_frozen(str);
+    VALUE result = rb_mutex_synchronize(this->lock, detector_detect_all_locked, (VALUE)&args);
+    RB_GC_GUARD(args.str);
+    return result;
+}
+
+typedef struct {
+    UConverter* source;
+    UConverter* target;
+    const char* src;
+    const char* src_limit;
+    char* dest;
+    char* dest_limit;
+    UChar pivot[DETECTOR_PIVOT_SIZE];
+    UChar* pivot_source;
+    UChar* pivot_target;
+    UBool reset;
+    UBool flush;
+    UErrorCode status;
+} detector_convert_args;
+
+static void detector_convert_init(detector_convert_args* args, UConverter* source, UConverter* target)
+{
+    args->source = source;
+    args->target = target;
+    args->src = args->src_limit = k_empty_source;
+    args->pivot_source = args->pivot_target = args->pivot;
+    args->reset = TRUE;
+    args->flush = FALSE;
+}
+
+static void* detector_convert_nogvl(void* _args)
+{
+    detector_convert_args* args = _args;
+    ucnv_convertEx(args->target, args->source,
+                   &args->dest, args->dest_limit,
+                   &args->src, args->src_limit,
+                   args->pivot, &args->pivot_source, &args->pivot_target, args->pivot + DETECTOR_PIVOT_SIZE,
+                   args->reset, args->flush, &args->status);
+    args->reset = FALSE;
+    return NULL;
+}
+
+// converts the source of args to the end of result, which grows until all of it fits
+static void detector_convert_append(detector_convert_args* args, VALUE result)
+{
+    long len = RSTRING_LEN(result);
+    for (;;) {
+        char* dest_start = RSTRING_PTR(result) + len;
+        args->dest = dest_start;
+        args->dest_limit = RSTRING_PTR(result) + rb_str_capacity(result);
+        args->status = U_ZERO_ERROR;
+        icu_call_without_gvl_when(args->src_limit - args->src, detector_convert_nogvl, args);
+        len += args->dest - dest_start;
+        if (args->status != U_BUFFER_OVERFLOW_ERROR) {
+            break;
+        }
+        // continues where it stopped
+        rb_str_set_len(result, len);
+        rb_str_modify_expand(result, rb_str_capacity(result));
+    }
+    rb_str_set_len(result, len);
+    if (U_FAILURE(args->status)) {
+        icu_rb_raise_icu_error(args->status);
+    }
+}
+
+// a byte order mark of the detected charset is its signature, not part of the text
+static const char* detector_skip_signature(const char* src, const char* src_limit, const char* name)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = 0;
+    const char* signature = ucnv_detectUnicodeSignature(src, (int32_t)(src_limit - src), &len, &status);
+    return U_SUCCESS(status) && signature != NULL && strcmp(signature, name) == 0 ? src + len : src;
+}
+
+// the EBCDIC charsets are detected with the text direction as a suffix, which isn't
+// part of the converter name
+static void detector_converter_name(const char* name, char* dest)
+{
+    size_t len = strlen(name);
+    if (len > 4 && (strcmp(name + len - 4, "_rtl") == 0 || strcmp(name + len - 4, "_ltr") == 0)) {
+        len -= 4;
+    }
+    if (len >= UCNV_MAX_CONVERTER_NAME_LENGTH) {
+        len = UCNV_MAX_CONVERTER_NAME_LENGTH - 1;
+    }
+    memcpy(dest, name, len);
+    dest[len] = '\0';
+}
+
+static VALUE detector_to_utf8_locked(VALUE _args)
+{
+    detector_locked_args* locked_args = (detector_locked_args*)_args;
+    VALUE self = locked_args->self;
+    VALUE str = locked_args->str;
+    GET_DETECTOR(this);
 
+    const UCharsetMatch* match = detector_detect_internal(this, str);
     UErrorCode status = U_ZERO_ERROR;
-    int32_t len_matches = 0;
-    const UCharsetMatch** matches = ucsdet_detectAll(this->service, &len_matches, &status);
+    const char* detected_name = ucsdet_getName(match, &status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
-
-    VALUE result = rb_ary_new2(3); // pre-allocate some slots
-    for (int32_t i = 0; i < len_matches; ++i) {
-        rb_ary_push(result, detector_populate_match_struct(matches[i]));
+    char name[UCNV_MAX_CONVERTER_NAME_LENGTH];
+    detector_converter_name(detected_name, name);
+    // the converters are kept for the next string, which is likely in the same charset
+    if (this->source == NULL || strcmp(this->source_name, name) != 0) {
+        ucnv_close(this->source);
+        this->source = ucnv_open(name, &status);
+        if (U_FAILURE(status)) {
+            this->source = NULL;
+            icu_rb_raise_icu_error(status);
+        }
+        memcpy(this->source_name, name, sizeof(name));
     }
-    detector_reset_text(this);
+    if (this->target == NULL) {
+        this->target = ucnv_open("UTF-8", &status);
+        if (U_FAILURE(status)) {
+            this->target = NULL;
+            icu_rb_raise_icu_error(status);
+        }
+    }
+
+    detector_convert_args args;
+    detector_convert_init(&args, this->source, this->target);
+    args.src_limit = RSTRING_PTR(str) + RSTRING_LEN(str);
+    args.src = detector_skip_signature(RSTRING_PTR(str), args.src_limit, name);
+    args.flush = TRUE;
+    // plain text mostly needs a byte per byte
+    VALUE result = rb_str_buf_new(RSTRING_LEN(str) + 16);
+    rb_enc_associate_index(result, rb_utf8_encindex());
+    detector_convert_append(&args, result);
+    return result;
+}
+
+/* Detects the charset of str and converts it to a new UTF-8 String in one go, bytes
+   which are invalid in the detected charset are replaced. */
+VALUE detector_to_utf8(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_DETECTOR(this);
+
+    detector_locked_args args;
+    args.self = self;
+    args.str = rb_str_new_frozen(str);
+    VALUE result = rb_mutex_synchronize(this->lock, detector_to_utf8_locked, (VALUE)&args);
+    RB_GC_GUARD(args.str);
     return result;
 }
 
+typedef struct {
+    icu_stream stream;
+    VALUE self;
+    VALUE name; // of the charset detected from the first chunk
+    char converter_name[UCNV_MAX_CONVERTER_NAME_LENGTH];
+    detector_convert_args convert;
+} detector_stream_state;
+
+// detects the charset from the first chunk and borrows the converters from it to UTF-8
+static void detector_stream_open(detector_stream_state* state, VALUE chunk)
+{
+    VALUE self = state->self;
+    GET_DETECTOR(this);
+    detector_locked_args args;
+    args.self = self;
+    args.str = NIL_P(chunk) ? rb_str_new(NULL, 0) : chunk;
+    state->name = rb_mutex_synchronize(this->lock, detector_detect_name_locked, (VALUE)&args);
+
+    detector_converter_name(RSTRING_PTR(state->name), state->converter_name);
+    state->convert.source = icu_converter_borrow(state->converter_name);
+    // a second UTF-8 one when the text is UTF-8, the source replaces its invalid bytes
+    state->convert.target = icu_converter_borrow("UTF-8");
+    detector_convert_init(&state->convert, state->convert.source, state->convert.target);
+}
+
+static void detector_stream_process(icu_stream* stream, VALUE chunk)
+{
+    detector_stream_state* state = (detector_stream_state*)stream;
+    if (!NIL_P(chunk)) {
+        // io_in may keep the chunk and change it while the GVL is released, as with detect
+        chunk = rb_str_new_frozen(chunk);
+    }
+    if (state->convert.source == NULL) {
+        detector_stream_open(state, chunk);
+    }
+    if (NIL_P(chunk)) {
+        state->convert.src = state->convert.src_limit = k_empty_source;
+        state->convert.flush = TRUE;
+    } else {
+        state->convert.src_limit = RSTRING_PTR(chunk) + RSTRING_LEN(chunk);
+        state->convert.src = state->convert.reset // the first chunk
+                             ? detector_skip_signature(RSTRING_PTR(chunk), state->convert.src_limit, state->converter_name)
+                             : RSTRING_PTR(chunk);
+    }
+    VALUE out = rb_str_buf_new(state->convert.src_limit - state->convert.src + 16);
+    rb_enc_associate_index(out, rb_utf8_encindex());
+    detector_convert_append(&state->convert, out);
+    RB_GC_GUARD(chunk);
+    icu_stream_write(stream, out);
+}
+
+static void detector_stream_close(icu_stream* stream)
+{
+    detector_stream_state* state = (detector_stream_state*)stream;
+    icu_converter_give_back(state->converter_name, state->convert.source);
+    icu_converter_give_back("UTF-8", state->convert.target);
+}
+
+/* Reads io_in by chunks and writes it converted to UTF-8 to io_out, the charset is
+   detected from the first chunk. Returns the name of the detected charset. */
+VALUE detector_to_utf8_stream(int argc, VALUE* argv, VALUE self)
+{
+    detector_stream_state state;
+    icu_stream_init(&state.stream, argc, argv);
+    state.stream.process = detector_stream_process;
+    state.stream.close = detector_stream_close;
+    state.self = self;
+    state.name = Qnil;
+    state.converter_name[0] = '\0';
+    state.convert.source = state.convert.target = NULL;
+
+    icu_stream_run(&state.stream);
+    RB_GC_GUARD(state.self);
+    return state.name;
+}
+
 static inline VALUE detector_get_input_filter_internal(const icu_detector_data* this)
 {
     return ucsdet_isInputFilterEnabled(this->service) != 0 ? Qtrue : Qfalse;
@@ -174,6 +560,10 @@ void init_icu_charset_detector(void)
     rb_define_method(rb_cICU_CharsetDetector, "initialize", detector_initialize, -1);
     rb_define_method(rb_cICU_CharsetDetector, "detect", detector_detect, 1);
     rb_define_method(rb_cICU_CharsetDetector, "detect_all", detector_detect_all, 1);
+    rb_define_method(rb_cICU_CharsetDetector, "detect_name", detector_detect_name, 1);
+    rb_define_method(rb_cICU_CharsetDetector, "detect_many", detector_detect_many, 1);
+    rb_define_method(rb_cICU_CharsetDetector, "to_utf8", detector_to_utf8, 1);
+    rb_define_method(rb_cICU_CharsetDetector, "to_utf8_stream", detector_to_utf8_stream, -1);
     rb_define_method(rb_cICU_CharsetDetector, "input_filter", detector_get_input_filter, 0);
     rb_define_method(rb_cICU_CharsetDetector, "input_filter=", detector_set_input_filter, 1);
     rb_define_method(rb_cICU_CharsetDetector, "detectable_charsets", detector_detectable_charsets, 0);
@@ -1,11 +1,45 @@
 #include "icu.h"
 #include "unicode/ucol.h"
+#include "unicode/uiter.h"
+#include "ruby/util.h"
+#include <string.h>
 
 #define GET_COLLATOR(_data) icu_collator_data* _data; \
                             TypedData_Get_Struct(self, icu_collator_data, &icu_collator_type, _data)
 
 VALUE rb_cICU_Collator;
 static ID ID_valid;
+static ID ID_thread_collators;
+static ID ID_levels;
+static ID ID_max_bytes;
+
+typedef struct {
+    const char* name;
+    int value;
+} collator_symbol_value;
+
+static const collator_symbol_value collator_strengths[] = {
+    {"primary", UCOL_PRIMARY},
+    {"secondary", UCOL_SECONDARY},
+    {"tertiary", UCOL_TERTIARY},
+    {"quaternary", UCOL_QUATERNARY},
+    {"identical", UCOL_IDENTICAL},
+    {NULL, 0},
+};
+
+static const collator_symbol_value collator_alternates[] = {
+    {"non_ignorable", UCOL_NON_IGNORABLE},
+    {"shifted", UCOL_SHIFTED},
+    {NULL, 0},
+};
+
+static const collator_symbol_value collator_max_variables[] = {
+    {"space", UCOL_REORDER_CODE_SPACE},
+    {"punct", UCOL_REORDER_CODE_PUNCTUATION},
+    {"symbol", UCOL_REORDER_CODE_SYMBOL},
+    {"currency", UCOL_REORDER_CODE_CURRENCY},
+    {NULL, 0},
+};
 
 typedef struct {
     VALUE rb_instance;
@@ -53,6 +87,93 @@ VALUE collator_initialize(VALUE self, VALUE locale)
     return self;
 }
 
+struct UCollator* icu_collator_service(VALUE collator)
+{
+    icu_collator_data* this;
+    TypedData_Get_Struct(collator, icu_collator_data, &icu_collator_type, this);
+    return this->service;
+}
+
+/* Opened collators by canonical locale name, Collator.for hands out clones of them.
+   ICU caches the tailoring data but every ucol_open still resolves the locale.
+   ucol_open falls back to the root collator for any unknown name, so the registry
+   stops growing at COLLATOR_REGISTRY_MAX_SIZE names and later ones are opened uncached.
+   Only touched with the GVL held. */
+#define COLLATOR_REGISTRY_MAX_SIZE 64
+static st_table* collator_registry = NULL;
+
+// ucol_clone came with ICU 71, which deprecates ucol_safeClone
+static UCollator* collator_clone(const UCollator* prototype, UErrorCode* status)
+{
+#if U_ICU_VERSION_MAJOR_NUM >= 71
+    return ucol_clone(prototype, status);
+#else
+    return ucol_safeClone(prototype, NULL, NULL, status);
+#endif
+}
+
+static UCollator* collator_registry_clone(const char* locale, UErrorCode* status)
+{
+    char name[ULOC_FULLNAME_CAPACITY];
+    UErrorCode name_status = U_ZERO_ERROR;
+    uloc_canonicalize(locale, name, ULOC_FULLNAME_CAPACITY, &name_status);
+    if (name_status != U_ZERO_ERROR) { // too long or not terminated, ucol_open reports it
+        return ucol_open(locale, status);
+    }
+
+    if (collator_registry == NULL) {
+        collator_registry = st_init_strtable();
+    }
+    st_data_t prototype;
+    if (st_lookup(collator_registry, (st_data_t)name, &prototype)) {
+        return collator_clone((const UCollator*)prototype, status);
+    }
+    UCollator* service = ucol_open(name, status);
+    if (U_FAILURE(*status) || collator_registry->num_entries >= COLLATOR_REGISTRY_MAX_SIZE) {
+        return service;
+    }
+    st_insert(collator_registry, (st_data_t)ruby_strdup(name), (st_data_t)service);
+    return collator_clone(service, status);
+}
+
+/* Collator.for keeps this many collators per fiber before it starts over. */
+#define COLLATOR_SINGLETONS_MAX_SIZE 64
+
+/* Returns a frozen collator for the locale which belongs to the current fiber.
+   The collators live in a fiber-local variable (Thread#[]), so every fiber clones
+   its own from the process-wide registry on first use. */
+VALUE collator_singleton_for(VALUE klass, VALUE locale)
+{
+    StringValue(locale);
+    VALUE thread = rb_thread_current();
+    VALUE collators = rb_thread_local_aref(thread, ID_thread_collators);
+    if (NIL_P(collators)) {
+        collators = rb_hash_new();
+        rb_thread_local_aset(thread, ID_thread_collators, collators);
+    }
+    VALUE collator = rb_hash_lookup(collators, locale);
+    if (!NIL_P(collator)) {
+        return collator;
+    }
+
+    collator = collator_alloc(klass);
+    icu_collator_data* this;
+    TypedData_Get_Struct(collator, icu_collator_data, &icu_collator_type, this);
+    this->enc_idx = 0;
+    this->rb_instance = collator;
+    UErrorCode status = U_ZERO_ERROR;
+    this->service = collator_registry_clone(StringValueCStr(locale), &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    rb_obj_freeze(collator);
+    if (RHASH_SIZE(collators) >= COLLATOR_SINGLETONS_MAX_SIZE) {
+        rb_hash_clear(collators);
+    }
+    rb_hash_aset(collators, rb_str_new_frozen(locale), collator);
+    return collator;
+}
+
 /*ULOC_ACTUAL_LOCALE
   This is locale the data actually comes from.
 
@@ -80,34 +201,562 @@ VALUE collator_locale(int argc, VALUE* argv, VALUE self)
     return locale_str != NULL ? rb_str_new_cstr(locale_str) : Qnil;
 }
 
+/* A string ready to be compared: UTF-8 strings are read in place, others are
+   converted to UTF-16 once so repeated comparisons don't transcode them again.
+   Never copy it, the scratch buffer may point into itself. */
+typedef struct {
+    VALUE str;
+    int utf8;
+    icu_uscratch u_str;
+} collator_operand;
+
+static void collator_operand_init(collator_operand* operand, VALUE str)
+{
+    operand->str = str;
+    operand->utf8 = icu_is_rb_str_as_utf_8(str);
+    if (operand->utf8) {
+        icu_uscratch_init(&operand->u_str, 0);
+    } else {
+        icu_uscratch_from_rb_str(&operand->u_str, str);
+    }
+}
+
+static void collator_operand_set_iter(const collator_operand* operand, UCharIterator* iter)
+{
+    if (operand->utf8) {
+        uiter_setUTF8(iter, RSTRING_PTR(operand->str), RSTRING_LENINT(operand->str));
+    } else {
+        uiter_setString(iter, operand->u_str.ptr, operand->u_str.len);
+    }
+}
+
+static UCollationResult collator_compare_operands(const icu_collator_data* this,
+                                                  const collator_operand* a,
+                                                  const collator_operand* b)
+{
+    if (!a->utf8 && !b->utf8) {
+        return ucol_strcoll(this->service,
+                            a->u_str.ptr, a->u_str.len,
+                            b->u_str.ptr, b->u_str.len);
+    }
+
+    UCollationResult result;
+    UErrorCode status = U_ZERO_ERROR;
+    if (a->utf8 && b->utf8) {
+        result = ucol_strcollUTF8(this->service,
+                                  RSTRING_PTR(a->str),
+                                  RSTRING_LENINT(a->str),
+                                  RSTRING_PTR(b->str),
+                                  RSTRING_LENINT(b->str),
+                                  &status);
+    } else {
+        UCharIterator iter_a;
+        UCharIterator iter_b;
+        collator_operand_set_iter(a, &iter_a);
+        collator_operand_set_iter(b, &iter_b);
+        result = ucol_strcollIter(this->service, &iter_a, &iter_b, &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return result;
+}
+
+static UCollationResult collator_compare_internal(const icu_collator_data* this, VALUE str_a, VALUE str_b)
+{
+    collator_operand a;
+    collator_operand b;
+    collator_operand_init(&a, str_a);
+    collator_operand_init(&b, str_b);
+    UCollationResult result = collator_compare_operands(this, &a, &b);
+    icu_uscratch_free(&a.u_str);
+    icu_uscratch_free(&b.u_str);
+    return result;
+}
+
 VALUE collator_compare(VALUE self, VALUE str_a, VALUE str_b)
 {
     StringValue(str_a);
     StringValue(str_b);
     GET_COLLATOR(this);
-    UCollationResult result = UCOL_EQUAL;
+    return INT2NUM(collator_compare_internal(this, str_a, str_b));
+}
+
+/* Returns the index of the first string of sorted_ary which isn't less than needle
+   or nil when there is none, as sorted_ary.bsearch_index { |str| compare(str, needle) >= 0 }
+   does. sorted_ary must be sorted by this collator. The needle is converted once. */
+VALUE collator_bsearch_index(VALUE self, VALUE sorted_ary, VALUE needle)
+{
+    Check_Type(sorted_ary, T_ARRAY);
+    StringValue(needle);
+    GET_COLLATOR(this);
+
+    collator_operand target;
+    collator_operand_init(&target, needle);
+    long low = 0;
+    long high = RARRAY_LEN(sorted_ary);
+    while (low < high) {
+        long mid = low + (high - low) / 2;
+        VALUE str = RARRAY_AREF(sorted_ary, mid);
+        Check_Type(str, T_STRING); // no to_str, it could change the array under the search
+        collator_operand probe;
+        collator_operand_init(&probe, str);
+        UCollationResult result = collator_compare_operands(this, &probe, &target);
+        icu_uscratch_free(&probe.u_str);
+        if (result == UCOL_LESS) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    icu_uscratch_free(&target.u_str);
+    RB_GC_GUARD(needle);
+    return low < RARRAY_LEN(sorted_ary) ? LONG2NUM(low) : Qnil;
+}
+
+// prepares the string at index of ary, when there is one
+static int collator_merge_next(collator_operand* operand, VALUE ary, long index)
+{
+    icu_uscratch_free(&operand->u_str);
+    if (index >= RARRAY_LEN(ary)) {
+        return FALSE;
+    }
+    VALUE str = RARRAY_AREF(ary, index);
+    Check_Type(str, T_STRING);
+    collator_operand_init(operand, str);
+    return TRUE;
+}
+
+/* Merges two arrays sorted by this collator into a new sorted array. Equal strings
+   keep their order, the ones from a come first. Every string is converted once. */
+VALUE collator_merge(VALUE self, VALUE a, VALUE b)
+{
+    Check_Type(a, T_ARRAY);
+    Check_Type(b, T_ARRAY);
+    GET_COLLATOR(this);
+
+    long len_a = RARRAY_LEN(a);
+    long len_b = RARRAY_LEN(b);
+    VALUE result = rb_ary_new_capa(len_a + len_b);
+    long i = 0;
+    long j = 0;
+    collator_operand str_a;
+    collator_operand str_b;
+    icu_uscratch_init(&str_a.u_str, 0);
+    icu_uscratch_init(&str_b.u_str, 0);
+    int has_a = collator_merge_next(&str_a, a, i);
+    int has_b = collator_merge_next(&str_b, b, j);
+    while (has_a && has_b) {
+        if (collator_compare_operands(this, &str_b, &str_a) == UCOL_LESS) {
+            rb_ary_push(result, str_b.str);
+            has_b = collator_merge_next(&str_b, b, ++j);
+        } else {
+            rb_ary_push(result, str_a.str);
+            has_a = collator_merge_next(&str_a, a, ++i);
+        }
+    }
+    icu_uscratch_free(&str_a.u_str);
+    icu_uscratch_free(&str_b.u_str);
+    if (i < len_a) {
+        rb_ary_cat(result, RARRAY_CONST_PTR(a) + i, len_a - i);
+    }
+    if (j < len_b) {
+        rb_ary_cat(result, RARRAY_CONST_PTR(b) + j, len_b - j);
+    }
+    return result;
+}
+
+/* Writes the sort key of rb_str at offset of the buffer string and
+   returns the key length without the NUL terminator. The buffer is
+   grown when the key doesn't fit. */
+static int32_t collator_write_sort_key(const icu_collator_data* this, VALUE rb_str, VALUE buf, long offset)
+{
+    icu_uscratch u_str;
+    icu_uscratch_from_rb_str(&u_str, rb_str);
+    int32_t capa = (int32_t)(rb_str_capacity(buf) - offset);
+    int retried = FALSE;
+    int32_t len;
+    do {
+        len = ucol_getSortKey(this->service,
+                              u_str.ptr, u_str.len,
+                              (uint8_t*)RSTRING_PTR(buf) + offset, capa);
+        if (len == 0) {
+            icu_uscratch_free(&u_str);
+            rb_raise(rb_eICU_Error, "Sort key can't be generated.");
+        }
+        if (!retried && len > capa) {
+            retried = TRUE;
+            icu_count_retry(ICU_RETRY_SORT_KEY);
+            // grows geometrically so the keys written after this one fit too
+            long total = (long)rb_str_capacity(buf) * 2;
+            if (total < offset + len) {
+                total = offset + len;
+            }
+            capa = (int32_t)(total - offset);
+            rb_str_modify_expand(buf, total - RSTRING_LEN(buf));
+        } else {
+            break;
+        }
+    } while (retried);
+    icu_uscratch_free(&u_str);
+    rb_str_set_len(buf, offset + len - 1); // drops the NUL, keys never contain it otherwise
+    return len - 1;
+}
+
+#define COLLATOR_LEVEL_SEPARATOR 0x01
+
+// cuts the key before the separator which ends the given level
+static void collator_truncate_levels(VALUE key, int levels)
+{
+    const char* ptr = RSTRING_PTR(key);
+    long len = RSTRING_LEN(key);
+    for (long i = 0; i < len; ++i) {
+        if (ptr[i] == COLLATOR_LEVEL_SEPARATOR && --levels == 0) {
+            rb_str_set_len(key, i);
+            return;
+        }
+    }
+}
 
-    if (icu_is_rb_str_as_utf_8(str_a) &&
-        icu_is_rb_str_as_utf_8(str_b)) {
+/* Writes the sort key of str at offset of buf with ucol_nextSortKeyPart, which reads
+   UTF-8 strings in place instead of converting them, and returns the key length.
+   These keys match ucol_getSortKey ones in practice but ICU doesn't promise it,
+   so they are only ever compared with each other. With levels > 0 the generation
+   stops after the separator which ends that level, the separator isn't kept. */
+static int32_t collator_write_sort_key_parts(const icu_collator_data* this, VALUE str, VALUE buf, long offset,
+                                             int levels)
+{
+    collator_operand operand;
+    collator_operand_init(&operand, str);
+    UCharIterator iter;
+    collator_operand_set_iter(&operand, &iter);
+
+    rb_str_set_len(buf, offset);
+    long capa = (long)rb_str_capacity(buf) - offset;
+    int32_t count = capa < 64 ? 64 : capa > INT32_MAX ? INT32_MAX : (int32_t)capa;
+    int32_t len = 0;
+    uint32_t state[2] = {0, 0};
+    for (;;) {
+        rb_str_modify_expand(buf, count - len);
         UErrorCode status = U_ZERO_ERROR;
-        result = ucol_strcollUTF8(this->service,
-                                  RSTRING_PTR(str_a),
-                                  RSTRING_LENINT(str_a),
-                                  RSTRING_PTR(str_b),
-                                  RSTRING_LENINT(str_b),
-                                  &status);
+        int32_t written = ucol_nextSortKeyPart(this->service, &iter, state,
+                                               (uint8_t*)RSTRING_PTR(buf) + offset + len,
+                                               count - len, &status);
         if (U_FAILURE(status)) {
+            icu_uscratch_free(&operand.u_str);
             icu_rb_raise_icu_error(status);
         }
+        int32_t part_start = len;
+        len += written;
+        int done = len < count;
+        if (levels > 0) {
+            const char* ptr = RSTRING_PTR(buf) + offset;
+            for (int32_t i = part_start; i < len; ++i) {
+                if (ptr[i] == COLLATOR_LEVEL_SEPARATOR && --levels == 0) {
+                    len = i;
+                    done = TRUE;
+                    break;
+                }
+            }
+        }
+        rb_str_set_len(buf, offset + len);
+        if (done) {
+            break;
+        }
+        if (count == INT32_MAX) {
+            icu_uscratch_free(&operand.u_str);
+            rb_raise(rb_eICU_Error, "Sort key can't be generated.");
+        }
+        // ICU walks the string from its start on every call, doubling keeps the calls few
+        icu_count_retry(ICU_RETRY_SORT_KEY);
+        count = count > INT32_MAX / 2 ? INT32_MAX : count * 2;
+    }
+    icu_uscratch_free(&operand.u_str);
+    RB_GC_GUARD(str);
+    return len;
+}
+
+/* Writes the first max_bytes bytes of the sort key with ucol_nextSortKeyPart,
+   long strings are only processed as far as those bytes need. The part is
+   asked for in one call: every call starts over from the beginning of str. */
+static VALUE collator_sort_key_prefix(const icu_collator_data* this, VALUE str, long max_bytes)
+{
+    UCharIterator iter;
+    icu_uscratch u_str;
+    u_str.heap = 0;
+    if (icu_is_rb_str_as_utf_8(str)) {
+        uiter_setUTF8(&iter, RSTRING_PTR(str), RSTRING_LENINT(str));
     } else {
-        VALUE tmp_a = icu_ustring_from_rb_str(str_a);
-        VALUE tmp_b = icu_ustring_from_rb_str(str_b);
-        result = ucol_strcoll(this->service,
-                              icu_ustring_ptr(tmp_a), icu_ustring_len(tmp_a),
-                              icu_ustring_ptr(tmp_b), icu_ustring_len(tmp_b));
+        icu_uscratch_from_rb_str(&u_str, str);
+        uiter_setString(&iter, u_str.ptr, u_str.len);
+    }
+
+    int32_t count = max_bytes > INT32_MAX ? INT32_MAX : (int32_t)max_bytes;
+    VALUE buf = rb_str_buf_new(count);
+    uint32_t state[2] = {0, 0};
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = ucol_nextSortKeyPart(this->service, &iter, state, (uint8_t*)RSTRING_PTR(buf), count, &status);
+    icu_uscratch_free(&u_str);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    rb_str_set_len(buf, len);
+    return buf;
+}
+
+/* Returns the binary sort key of str, keys compare bytewise as the strings do with compare.
+   With levels: the key stops after that many levels (1 is primary only). With max_bytes:
+   the key is cut after that many bytes, a prefix that still orders strings correctly
+   except the ones it can't tell apart anymore. */
+VALUE collator_sort_key(int argc, VALUE* argv, VALUE self)
+{
+    VALUE str;
+    VALUE opts;
+    rb_scan_args(argc, argv, "1:", &str, &opts);
+    StringValue(str);
+    GET_COLLATOR(this);
+
+    if (!NIL_P(opts)) {
+        ID keywords[2] = {ID_levels, ID_max_bytes};
+        VALUE values[2];
+        rb_get_kwargs(opts, keywords, 0, 2, values);
+        int levels = values[0] == Qundef || NIL_P(values[0]) ? -1 : NUM2INT(values[0]);
+        long max_bytes = values[1] == Qundef || NIL_P(values[1]) ? -1 : NUM2LONG(values[1]);
+        if (values[0] != Qundef && !NIL_P(values[0]) && levels <= 0) {
+            rb_raise(rb_eArgError, "levels must be positive");
+        }
+        if (values[1] != Qundef && !NIL_P(values[1]) && max_bytes < 0) {
+            rb_raise(rb_eArgError, "max_bytes can't be negative");
+        }
+        if (max_bytes >= 0) {
+            VALUE key = collator_sort_key_prefix(this, str, max_bytes);
+            if (levels > 0) {
+                collator_truncate_levels(key, levels);
+            }
+            return key;
+        }
+        if (levels > 0) {
+            VALUE key = rb_str_buf_new(RSTRING_LEN(str) * 2 + RUBY_C_STRING_TERMINATOR_SIZE);
+            collator_write_sort_key_parts(this, str, key, 0, levels);
+            return key;
+        }
     }
 
-    return INT2NUM(result);
+    VALUE buf = rb_str_buf_new(RSTRING_LEN(str) * 2 + RUBY_C_STRING_TERMINATOR_SIZE);
+    collator_write_sort_key(this, str, buf, 0);
+    return buf;
+}
+
+/* Returns the lower and upper bound keys of the strings starting with prefix, compared
+   on the first levels levels: lower <= sort_key(str) < upper for every such str. */
+VALUE collator_key_range(int argc, VALUE* argv, VALUE self)
+{
+    VALUE prefix;
+    VALUE opts;
+    rb_scan_args(argc, argv, "1:", &prefix, &opts);
+    StringValue(prefix);
+    GET_COLLATOR(this);
+
+    int32_t levels = 1;
+    if (!NIL_P(opts)) {
+        ID keywords[1] = {ID_levels};
+        VALUE values[1];
+        rb_get_kwargs(opts, keywords, 0, 1, values);
+        if (values[0] != Qundef && !NIL_P(values[0])) {
+            levels = NUM2INT(values[0]);
+            if (levels <= 0) {
+                rb_raise(rb_eArgError, "levels must be positive");
+            }
+        }
+    }
+
+    VALUE key = rb_str_buf_new(RSTRING_LEN(prefix) * 2 + RUBY_C_STRING_TERMINATOR_SIZE);
+    int32_t key_len = collator_write_sort_key(this, prefix, key, 0) + 1; // ucol_getBound wants the NUL
+    rb_str_modify_expand(key, 1);
+    RSTRING_PTR(key)[key_len - 1] = '\0';
+
+    VALUE result = rb_ary_new_capa(2);
+    const UColBoundMode modes[2] = {UCOL_BOUND_LOWER, UCOL_BOUND_UPPER_LONG};
+    for (int i = 0; i < 2; ++i) {
+        // a bound adds at most two bytes per level
+        int32_t capa = key_len + levels * 2 + RUBY_C_STRING_TERMINATOR_SIZE;
+        VALUE bound = rb_str_buf_new(capa);
+        UErrorCode status = U_ZERO_ERROR;
+        int32_t len = ucol_getBound((const uint8_t*)RSTRING_PTR(key), key_len, modes[i], levels,
+                                    (uint8_t*)RSTRING_PTR(bound), capa, &status);
+        if (status == U_BUFFER_OVERFLOW_ERROR) {
+            rb_str_modify_expand(bound, len);
+            status = U_ZERO_ERROR;
+            len = ucol_getBound((const uint8_t*)RSTRING_PTR(key), key_len, modes[i], levels,
+                                (uint8_t*)RSTRING_PTR(bound), len, &status);
+        }
+        if (U_FAILURE(status)) {
+            icu_rb_raise_icu_error(status);
+        }
+        rb_str_set_len(bound, len - 1); // drops the NUL as sort_key does
+        rb_ary_push(result, bound);
+    }
+    RB_GC_GUARD(key);
+    return result;
+}
+
+typedef struct {
+    long offset;
+    int32_t len;
+    long index;
+} collator_sort_entry;
+
+// keys is the start of the sort keys the entries point into
+static int collator_sort_entry_cmp(const void* a, const void* b, void* keys)
+{
+    const collator_sort_entry* entry_a = a;
+    const collator_sort_entry* entry_b = b;
+    const uint8_t* keys_ptr = keys;
+    int32_t min_len = entry_a->len < entry_b->len ? entry_a->len : entry_b->len;
+    int result = memcmp(keys_ptr + entry_a->offset,
+                        keys_ptr + entry_b->offset,
+                        min_len);
+    if (result != 0) {
+        return result;
+    }
+    if (entry_a->len != entry_b->len) {
+        return entry_a->len < entry_b->len ? -1 : 1;
+    }
+    // keep the input order for equal keys
+    return entry_a->index < entry_b->index ? -1 : (entry_a->index > entry_b->index);
+}
+
+// writes the sort keys of the strings of ary one after another into keys
+static void collator_write_sort_keys(const icu_collator_data* this, VALUE ary, collator_sort_entry* entries, VALUE keys)
+{
+    long offset = 0;
+    for (long i = 0; i < RARRAY_LEN(ary); ++i) {
+        VALUE str = rb_ary_entry(ary, i);
+        StringValue(str);
+        entries[i].offset = offset;
+        entries[i].index = i;
+        entries[i].len = collator_write_sort_key(this, str, keys, offset);
+        offset += entries[i].len;
+    }
+}
+
+/* Sorts by the binary sort keys, each key is computed only once.
+   The keys are kept in one Ruby string so an exception won't leak them. */
+VALUE collator_sort(VALUE self, VALUE ary)
+{
+    ary = rb_ary_dup(rb_convert_type(ary, T_ARRAY, "Array", "to_ary"));
+    GET_COLLATOR(this);
+
+    long len = RARRAY_LEN(ary);
+    VALUE entries_buf;
+    collator_sort_entry* entries = ALLOCV_N(collator_sort_entry, entries_buf, len);
+    VALUE keys = rb_str_buf_new(len * 16);
+    collator_write_sort_keys(this, ary, entries, keys);
+
+    ruby_qsort(entries, len, sizeof(collator_sort_entry), collator_sort_entry_cmp, RSTRING_PTR(keys));
+
+    VALUE result = rb_ary_new2(len);
+    for (long i = 0; i < len; ++i) {
+        rb_ary_push(result, rb_ary_entry(ary, entries[i].index));
+    }
+    ALLOCV_END(entries_buf);
+    RB_GC_GUARD(keys);
+    return result;
+}
+
+// 64 bit FNV-1a, the same in every process unlike rb_memhash which is seeded at boot
+static uint64_t collator_sort_key_hash(const uint8_t* ptr, int32_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int32_t i = 0; i < len; ++i) {
+        hash = (hash ^ ptr[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/* Returns a hash of the sort key of str: strings which compare equal at the
+   configured strength get the same hash key, unequal ones rarely collide.
+   The hash doesn't depend on the process, so it can be stored, but it changes
+   with the collator settings and with the collation data of the ICU version. */
+VALUE collator_hash_key(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_COLLATOR(this);
+
+    VALUE key = rb_str_buf_new(RSTRING_LEN(str) * 2 + RUBY_C_STRING_TERMINATOR_SIZE);
+    int32_t len = collator_write_sort_key_parts(this, str, key, 0, 0);
+    uint64_t hash = collator_sort_key_hash((const uint8_t*)RSTRING_PTR(key), len);
+    RB_GC_GUARD(key);
+    return ULL2NUM(hash >> 2); // a Fixnum on 64 bit platforms
+}
+
+/* Groups the strings which compare equal at the configured strength, returns
+   the groups in the order of their first string. Strings are bucketed by their
+   sort keys, so it takes linear time. */
+VALUE collator_group_by(VALUE self, VALUE ary)
+{
+    ary = rb_ary_dup(rb_convert_type(ary, T_ARRAY, "Array", "to_ary"));
+    GET_COLLATOR(this);
+
+    long len = RARRAY_LEN(ary);
+    VALUE entries_buf;
+    collator_sort_entry* entries = ALLOCV_N(collator_sort_entry, entries_buf, len);
+    VALUE group_of_buf;
+    long* group_of = ALLOCV_N(long, group_of_buf, len);
+    VALUE keys = rb_str_buf_new(len * 16);
+    long offset = 0;
+    for (long i = 0; i < len; ++i) {
+        VALUE str = rb_ary_entry(ary, i);
+        StringValue(str);
+        entries[i].offset = offset;
+        entries[i].index = i;
+        entries[i].len = collator_write_sort_key_parts(this, str, keys, offset, 0);
+        offset += entries[i].len;
+    }
+
+    // open addressing over the first entry of every group, slots hold its index + 1
+    long slots_capa = 16;
+    while (slots_capa < len * 2) {
+        slots_capa *= 2;
+    }
+    VALUE slots_buf;
+    long* slots = ALLOCV_N(long, slots_buf, slots_capa);
+    MEMZERO(slots, long, slots_capa);
+    const uint8_t* keys_ptr = (const uint8_t*)RSTRING_PTR(keys);
+    long groups_len = 0;
+    for (long i = 0; i < len; ++i) {
+        const collator_sort_entry* entry = &entries[i];
+        long slot = (long)(collator_sort_key_hash(keys_ptr + entry->offset, entry->len) & (slots_capa - 1));
+        for (;;) {
+            if (slots[slot] == 0) {
+                slots[slot] = i + 1;
+                group_of[i] = groups_len++;
+                break;
+            }
+            const collator_sort_entry* first = &entries[slots[slot] - 1];
+            if (first->len == entry->len &&
+                memcmp(keys_ptr + first->offset, keys_ptr + entry->offset, entry->len) == 0) {
+                group_of[i] = group_of[slots[slot] - 1];
+                break;
+            }
+            slot = (slot + 1) & (slots_capa - 1);
+        }
+    }
+    ALLOCV_END(slots_buf);
+
+    VALUE result = rb_ary_new_capa(groups_len);
+    for (long i = 0; i < len; ++i) {
+        VALUE str = rb_ary_entry(ary, i);
+        if (group_of[i] == RARRAY_LEN(result)) { // the first string of a group
+            rb_ary_push(result, rb_ary_new_from_args(1, str));
+        } else {
+            rb_ary_push(RARRAY_AREF(result, group_of[i]), str);
+        }
+    }
+    ALLOCV_END(entries_buf);
+    ALLOCV_END(group_of_buf);
+    RB_GC_GUARD(keys);
+    return result;
 }
 
 VALUE collator_rules(VALUE self)
@@ -121,18 +770,177 @@ VALUE collator_rules(VALUE self)
     return ret;
 }
 
+static int collator_symbol_to_value(const collator_symbol_value* values, const char* parameter, VALUE sym)
+{
+    Check_Type(sym, T_SYMBOL);
+    const char* name = rb_id2name(SYM2ID(sym));
+    for (; values->name != NULL; ++values) {
+        if (strcmp(values->name, name) == 0) {
+            return values->value;
+        }
+    }
+    icu_rb_raise_icu_invalid_parameter(parameter, "unknown value");
+    return 0;
+}
+
+static VALUE collator_value_to_symbol(const collator_symbol_value* values, int value)
+{
+    for (; values->name != NULL; ++values) {
+        if (values->value == value) {
+            return ID2SYM(rb_intern(values->name));
+        }
+    }
+    return Qnil;
+}
+
+static UColAttributeValue collator_get_attribute(const icu_collator_data* this, UColAttribute attribute)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    UColAttributeValue value = ucol_getAttribute(this->service, attribute, &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return value;
+}
+
+// collators from Collator.for are frozen, they are shared within a thread
+static void collator_set_attribute(VALUE self, UColAttribute attribute, UColAttributeValue value)
+{
+    rb_check_frozen(self);
+    GET_COLLATOR(this);
+    UErrorCode status = U_ZERO_ERROR;
+    ucol_setAttribute(this->service, attribute, value, &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+}
+
+VALUE collator_get_strength(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_value_to_symbol(collator_strengths, collator_get_attribute(this, UCOL_STRENGTH));
+}
+
+/* :primary compares base letters only, :secondary adds accents, :tertiary adds case. */
+VALUE collator_set_strength(VALUE self, VALUE strength)
+{
+    collator_set_attribute(self, UCOL_STRENGTH,
+                           collator_symbol_to_value(collator_strengths, "strength", strength));
+    return strength;
+}
+
+VALUE collator_get_alternate(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_value_to_symbol(collator_alternates, collator_get_attribute(this, UCOL_ALTERNATE_HANDLING));
+}
+
+/* :shifted ignores spaces and punctuation up to max_variable below the quaternary level. */
+VALUE collator_set_alternate(VALUE self, VALUE alternate)
+{
+    collator_set_attribute(self, UCOL_ALTERNATE_HANDLING,
+                           collator_symbol_to_value(collator_alternates, "alternate", alternate));
+    return alternate;
+}
+
+VALUE collator_get_case_level(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_get_attribute(this, UCOL_CASE_LEVEL) == UCOL_ON ? Qtrue : Qfalse;
+}
+
+/* Adds a level for case only, so a primary strength comparison can tell case without accents. */
+VALUE collator_set_case_level(VALUE self, VALUE case_level)
+{
+    collator_set_attribute(self, UCOL_CASE_LEVEL, RTEST(case_level) ? UCOL_ON : UCOL_OFF);
+    return case_level;
+}
+
+VALUE collator_get_numeric(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_get_attribute(this, UCOL_NUMERIC_COLLATION) == UCOL_ON ? Qtrue : Qfalse;
+}
+
+/* Compares sequences of digits by their numeric value. */
+VALUE collator_set_numeric(VALUE self, VALUE numeric)
+{
+    collator_set_attribute(self, UCOL_NUMERIC_COLLATION, RTEST(numeric) ? UCOL_ON : UCOL_OFF);
+    return numeric;
+}
+
+VALUE collator_get_normalization(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_get_attribute(this, UCOL_NORMALIZATION_MODE) == UCOL_ON ? Qtrue : Qfalse;
+}
+
+/* Normalizes the input before comparing, it can stay off for text in NFD or FCD. */
+VALUE collator_set_normalization(VALUE self, VALUE normalization)
+{
+    collator_set_attribute(self, UCOL_NORMALIZATION_MODE, RTEST(normalization) ? UCOL_ON : UCOL_OFF);
+    return normalization;
+}
+
+VALUE collator_get_max_variable(VALUE self)
+{
+    GET_COLLATOR(this);
+    return collator_value_to_symbol(collator_max_variables, ucol_getMaxVariable(this->service));
+}
+
+/* The last group of characters :shifted ignores, one of :space, :punct, :symbol or :currency. */
+VALUE collator_set_max_variable(VALUE self, VALUE max_variable)
+{
+    rb_check_frozen(self);
+    GET_COLLATOR(this);
+    UErrorCode status = U_ZERO_ERROR;
+    ucol_setMaxVariable(this->service,
+                        collator_symbol_to_value(collator_max_variables, "max_variable", max_variable),
+                        &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return max_variable;
+}
+
 void init_icu_collator(void)
 {
     ID_valid = rb_intern("valid");
+    ID_thread_collators = rb_intern("__icu_collators__");
+    ID_levels = rb_intern("levels");
+    ID_max_bytes = rb_intern("max_bytes");
 
     rb_cICU_Collator = rb_define_class_under(rb_mICU, "Collator", rb_cObject);
     rb_define_alloc_func(rb_cICU_Collator, collator_alloc);
+    rb_define_singleton_method(rb_cICU_Collator, "for", collator_singleton_for, 1);
     rb_define_method(rb_cICU_Collator, "initialize", collator_initialize, 1);
     rb_define_method(rb_cICU_Collator, "locale", collator_locale, -1);
     rb_define_method(rb_cICU_Collator, "compare", collator_compare, 2);
+    rb_define_method(rb_cICU_Collator, "bsearch_index", collator_bsearch_index, 2);
+    rb_define_method(rb_cICU_Collator, "merge", collator_merge, 2);
     rb_define_method(rb_cICU_Collator, "rules", collator_rules, 0);
+    rb_define_method(rb_cICU_Collator, "sort_key", collator_sort_key, -1);
+    rb_define_method(rb_cICU_Collator, "key_range", collator_key_range, -1);
+    rb_define_method(rb_cICU_Collator, "sort", collator_sort, 1);
+    rb_define_method(rb_cICU_Collator, "hash_key", collator_hash_key, 1);
+    rb_define_method(rb_cICU_Collator, "group_by", collator_group_by, 1);
+    rb_define_method(rb_cICU_Collator, "strength", collator_get_strength, 0);
+    rb_define_method(rb_cICU_Collator, "strength=", collator_set_strength, 1);
+    rb_define_method(rb_cICU_Collator, "alternate", collator_get_alternate, 0);
+    rb_define_method(rb_cICU_Collator, "alternate=", collator_set_alternate, 1);
+    rb_define_method(rb_cICU_Collator, "case_level", collator_get_case_level, 0);
+    rb_define_method(rb_cICU_Collator, "case_level=", collator_set_case_level, 1);
+    rb_define_method(rb_cICU_Collator, "numeric", collator_get_numeric, 0);
+    rb_define_method(rb_cICU_Collator, "numeric=", collator_set_numeric, 1);
+    rb_define_method(rb_cICU_Collator, "normalization", collator_get_normalization, 0);
+    rb_define_method(rb_cICU_Collator, "normalization=", collator_set_normalization, 1);
+    rb_define_method(rb_cICU_Collator, "max_variable", collator_get_max_variable, 0);
+    rb_define_method(rb_cICU_Collator, "max_variable=", collator_set_max_variable, 1);
 }
 
+#undef COLLATOR_LEVEL_SEPARATOR
+#undef COLLATOR_REGISTRY_MAX_SIZE
+#undef COLLATOR_SINGLETONS_MAX_SIZE
 #undef GET_COLLATOR
 
 /* vim: set expandtab sws=4 sw=4: */
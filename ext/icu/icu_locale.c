@@ -3,6 +3,9 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define GET_LOCALE(_data) icu_locale_data* _data; \
+                          TypedData_Get_Struct(self, icu_locale_data, &icu_locale_type, _data)
+
 VALUE rb_cICU_Locale;
 static ID ID_ltr;
 static ID ID_rtl;
@@ -10,17 +13,183 @@ static ID ID_ttb;
 static ID ID_btt;
 static ID ID_unknown;
 
+// the components parsed from the id by uloc_*, cached on the first call
+enum {
+    LOCALE_LANGUAGE,
+    LOCALE_COUNTRY,
+    LOCALE_SCRIPT,
+    LOCALE_VARIANT,
+    LOCALE_NAME,
+    LOCALE_BASE_NAME,
+    LOCALE_CANONICAL_NAME,
+    LOCALE_PARENT,
+    LOCALE_LANGUAGE_TAG,
+    LOCALE_STRICT_LANGUAGE_TAG,
+    LOCALE_ISO_COUNTRY,
+    LOCALE_ISO_LANGUAGE,
+    LOCALE_LIKELY_SUBTAGS,
+    LOCALE_MINIMIZED_SUBTAGS,
+    LOCALE_COMPONENT_COUNT
+};
+
+typedef int32_t (*locale_component_fn)(const char* id, char* buffer, int32_t capa, UErrorCode* status);
+
+typedef struct {
+    VALUE rb_instance;
+    VALUE id; // frozen, the locale never changes
+    VALUE components[LOCALE_COMPONENT_COUNT]; // Qundef until cached
+} icu_locale_data;
+
+static void locale_mark(void* _this)
+{
+    icu_locale_data* this = _this;
+    rb_gc_mark(this->id);
+    for (int i = 0; i < LOCALE_COMPONENT_COUNT; ++i) {
+        rb_gc_mark(this->components[i]);
+    }
+}
+
+static size_t locale_memsize(const void* _)
+{
+    return sizeof(icu_locale_data);
+}
+
+static const rb_data_type_t icu_locale_type = {
+    "icu/locale",
+    {locale_mark, RUBY_TYPED_DEFAULT_FREE, locale_memsize,},
+    0, 0,
+    RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+VALUE locale_alloc(VALUE self)
+{
+    icu_locale_data* this;
+    VALUE obj = TypedData_Make_Struct(self, icu_locale_data, &icu_locale_type, this);
+    this->rb_instance = obj;
+    this->id = Qnil;
+    for (int i = 0; i < LOCALE_COMPONENT_COUNT; ++i) {
+        this->components[i] = Qundef;
+    }
+    return obj;
+}
+
+static void locale_set_id(VALUE self, VALUE id)
+{
+    GET_LOCALE(this);
+    this->id = rb_obj_freeze(id);
+    for (int i = 0; i < LOCALE_COMPONENT_COUNT; ++i) {
+        this->components[i] = Qundef;
+    }
+}
+
 VALUE locale_initialize(VALUE self, VALUE id)
 {
-    id = rb_str_enc_to_ascii_as_utf8(id);
-    rb_iv_set(self, "@id", id);
+    // a new string, the argument itself isn't frozen
+    locale_set_id(self, rb_str_enc_to_ascii_as_utf8(id));
+    return self;
+}
+
+VALUE locale_initialize_copy(VALUE self, VALUE other)
+{
+    if (self == other) {
+        return self;
+    }
+    rb_obj_init_copy(self, other);
+    GET_LOCALE(this);
+    icu_locale_data* that;
+    TypedData_Get_Struct(other, icu_locale_data, &icu_locale_type, that);
+    this->id = that->id;
+    // the components are frozen or locales which are never changed, the copy shares them
+    MEMCPY(this->components, that->components, VALUE, LOCALE_COMPONENT_COUNT);
     return self;
 }
 
+static inline VALUE locale_id(VALUE self)
+{
+    GET_LOCALE(this);
+    if (NIL_P(this->id)) {
+        rb_raise(rb_eTypeError, "uninitialized %"PRIsVALUE, rb_obj_class(self));
+    }
+    return this->id;
+}
+
 inline static VALUE locale_new_from_cstr(const char* str)
 {
-    VALUE rb_str = rb_str_new_cstr(str);
-    return locale_initialize(rb_obj_alloc(rb_cICU_Locale), rb_str_enc_to_ascii_as_utf8(rb_str));
+    VALUE loc = rb_obj_alloc(rb_cICU_Locale);
+    // uloc_* output is ASCII
+    locale_set_id(loc, rb_utf8_str_new_cstr(str));
+    return loc;
+}
+
+// runs fn over the id, the result fits the stack buffer unless the id is unusually long
+static VALUE locale_component_str(VALUE id, locale_component_fn fn)
+{
+    char stack_buffer[ULOC_FULLNAME_CAPACITY];
+    char* buffer = stack_buffer;
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = fn(RSTRING_PTR(id), buffer, ULOC_FULLNAME_CAPACITY, &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        VALUE heap_str = rb_str_buf_new(len);
+        status = U_ZERO_ERROR;
+        len = fn(RSTRING_PTR(id), RSTRING_PTR(heap_str), len + RUBY_C_STRING_TERMINATOR_SIZE, &status);
+        if (U_FAILURE(status)) {
+            icu_rb_raise_icu_error(status);
+        }
+        rb_str_set_len(heap_str, len);
+        rb_enc_associate(heap_str, rb_utf8_encoding());
+        return heap_str;
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return rb_utf8_str_new(buffer, len);
+}
+
+static VALUE locale_cached_component(VALUE self, int component, locale_component_fn fn)
+{
+    VALUE id = locale_id(self);
+    GET_LOCALE(this);
+    if (this->components[component] == Qundef) {
+        this->components[component] = rb_obj_freeze(locale_component_str(id, fn));
+    }
+    return this->components[component];
+}
+
+static VALUE locale_cached_locale(VALUE self, int component, locale_component_fn fn)
+{
+    VALUE id = locale_id(self);
+    GET_LOCALE(this);
+    if (this->components[component] == Qundef) {
+        VALUE loc = rb_obj_alloc(rb_cICU_Locale);
+        locale_set_id(loc, locale_component_str(id, fn));
+        this->components[component] = loc;
+    }
+    return this->components[component];
+}
+
+static VALUE locale_cached_cstr(VALUE self, int component, const char* (*fn)(const char*))
+{
+    VALUE id = locale_id(self);
+    GET_LOCALE(this);
+    if (this->components[component] == Qundef) {
+        this->components[component] = rb_obj_freeze(rb_utf8_str_new_cstr(fn(RSTRING_PTR(id))));
+    }
+    return this->components[component];
+}
+
+static int32_t locale_to_language_tag(const char* id, char* buffer, int32_t capa, UErrorCode* status)
+{
+    return uloc_toLanguageTag(id, buffer, capa, FALSE, status);
+}
+
+static int32_t locale_to_strict_language_tag(const char* id, char* buffer, int32_t capa, UErrorCode* status)
+{
+    return uloc_toLanguageTag(id, buffer, capa, TRUE, status);
+}
+
+VALUE locale_get_id(VALUE self)
+{
+    return locale_id(self);
 }
 
 VALUE locale_singleton_available(VALUE klass)
@@ -149,44 +318,15 @@ VALUE locale_language_tag(int argc, VALUE* argv, VALUE self)
 {
     VALUE strict;
     rb_scan_args(argc, argv, "01", &strict);
-    if (strict != Qtrue) {
-        strict = Qfalse;
+    if (strict == Qtrue) {
+        return locale_cached_component(self, LOCALE_STRICT_LANGUAGE_TAG, locale_to_strict_language_tag);
     }
-
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_toLanguageTag(RSTRING_PTR(id),
-                                 buffer,
-                                 buffer_capa,
-                                 strict == Qtrue ? TRUE : FALSE,
-                                 &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE loc = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return loc;
+    return locale_cached_component(self, LOCALE_LANGUAGE_TAG, locale_to_language_tag);
 }
 
 VALUE locale_lcid(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     return ULONG2NUM(uloc_getLCID(RSTRING_PTR(id)));
 }
 
@@ -198,7 +338,7 @@ VALUE locale_display_country(int argc, VALUE* argv, VALUE self)
         display_locale = rb_str_enc_to_ascii_as_utf8(display_locale);
     }
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     VALUE buffer = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -232,7 +372,7 @@ VALUE locale_display_language(int argc, VALUE* argv, VALUE self)
                                                       locale_singleton_get_default_internal() :
                                                       display_locale));
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     VALUE buffer = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -264,7 +404,7 @@ VALUE locale_display_name(int argc, VALUE* argv, VALUE self)
         display_locale = rb_str_enc_to_ascii_as_utf8(display_locale);
     }
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     VALUE buffer = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -296,7 +436,7 @@ VALUE locale_display_script(int argc, VALUE* argv, VALUE self)
         display_locale = rb_str_enc_to_ascii_as_utf8(display_locale);
     }
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     VALUE buffer = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -328,7 +468,7 @@ VALUE locale_display_variant(int argc, VALUE* argv, VALUE self)
         display_locale = rb_str_enc_to_ascii_as_utf8(display_locale);
     }
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     VALUE buffer = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -354,149 +494,39 @@ VALUE locale_display_variant(int argc, VALUE* argv, VALUE self)
 
 VALUE locale_name(VALUE self)
 {
-    int32_t buffer_capa = 64;
-    VALUE id = rb_iv_get(self, "@id");
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getName(RSTRING_PTR(id),
-                           buffer,
-                           buffer_capa,
-                           &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_NAME, uloc_getName);
 }
 
 VALUE locale_base_name(VALUE self)
 {
-    int32_t buffer_capa = 64;
-    VALUE id = rb_iv_get(self, "@id");
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getBaseName(RSTRING_PTR(id),
-                               buffer,
-                               buffer_capa,
-                               &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_BASE_NAME, uloc_getBaseName);
 }
 
 VALUE locale_canonical_name(VALUE self)
 {
-    int32_t buffer_capa = 64;
-    VALUE id = rb_iv_get(self, "@id");
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_canonicalize(RSTRING_PTR(id),
-                                buffer,
-                                buffer_capa,
-                                &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_CANONICAL_NAME, uloc_canonicalize);
 }
 
 VALUE locale_parent(VALUE self)
 {
-    int32_t buffer_capa = 64;
-    VALUE id = rb_iv_get(self, "@id");
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getParent(RSTRING_PTR(id),
-                             buffer,
-                             buffer_capa,
-                             &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_PARENT, uloc_getParent);
 }
 
 VALUE locale_iso_country(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    return rb_str_new_cstr(uloc_getISO3Country(RSTRING_PTR(id)));
+    return locale_cached_cstr(self, LOCALE_ISO_COUNTRY, uloc_getISO3Country);
 }
 
 VALUE locale_iso_language(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    return rb_str_new_cstr(uloc_getISO3Language(RSTRING_PTR(id)));
+    return locale_cached_cstr(self, LOCALE_ISO_LANGUAGE, uloc_getISO3Language);
 }
 
 VALUE locale_keyword(VALUE self, VALUE keyword)
 {
     keyword = rb_str_enc_to_ascii_as_utf8(keyword);
     int32_t buffer_capa = 64;
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     char* buffer = char_buffer_new(buffer_capa);
     UErrorCode status = U_ZERO_ERROR;
     int retried = FALSE;
@@ -528,7 +558,7 @@ VALUE locale_keyword(VALUE self, VALUE keyword)
 
 VALUE locale_keywords(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     UErrorCode status = U_ZERO_ERROR;
     UEnumeration* result = uloc_openKeywords(RSTRING_PTR(id), &status);
     return icu_enum_to_rb_ary(result, status, 3);
@@ -546,7 +576,7 @@ VALUE locale_with_keyword(VALUE self, VALUE keyword, VALUE value)
         value = rb_str_enc_to_ascii_as_utf8(value);
     }
 
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     int32_t len_id = RSTRING_LENINT(id);
     int32_t buffer_capa = 64 + len_id + len_keyword + (NIL_P(value) ? 0 : RSTRING_LENINT(value));
     char* buffer = char_buffer_new(buffer_capa);
@@ -599,7 +629,7 @@ static inline VALUE locale_layout_symbol(ULayoutType result)
 
 VALUE locale_character_orientation(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     UErrorCode status = U_ZERO_ERROR;
     ULayoutType result = uloc_getCharacterOrientation(RSTRING_PTR(id), &status);
     return locale_layout_symbol(result);
@@ -607,7 +637,7 @@ VALUE locale_character_orientation(VALUE self)
 
 VALUE locale_line_orientation(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
+    VALUE id = locale_id(self);
     UErrorCode status = U_ZERO_ERROR;
     ULayoutType result = uloc_getLineOrientation(RSTRING_PTR(id), &status);
     return locale_layout_symbol(result);
@@ -615,194 +645,32 @@ VALUE locale_line_orientation(VALUE self)
 
 VALUE locale_country(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getCountry(RSTRING_PTR(id),
-                              buffer,
-                              buffer_capa,
-                              &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE loc = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return loc;
+    return locale_cached_component(self, LOCALE_COUNTRY, uloc_getCountry);
 }
 
 VALUE locale_language(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getLanguage(RSTRING_PTR(id),
-                               buffer,
-                               buffer_capa,
-                               &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE loc = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return loc;
+    return locale_cached_component(self, LOCALE_LANGUAGE, uloc_getLanguage);
 }
 
 VALUE locale_script(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getScript(RSTRING_PTR(id),
-                             buffer,
-                             buffer_capa,
-                             &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_SCRIPT, uloc_getScript);
 }
 
 VALUE locale_variant(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_getVariant(RSTRING_PTR(id),
-                              buffer,
-                              buffer_capa,
-                              &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = char_buffer_to_rb_str(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_component(self, LOCALE_VARIANT, uloc_getVariant);
 }
 
 VALUE locale_with_likely_subtags(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_addLikelySubtags(RSTRING_PTR(id),
-                                    buffer,
-                                    buffer_capa,
-                                    &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = locale_new_from_cstr(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_locale(self, LOCALE_LIKELY_SUBTAGS, uloc_addLikelySubtags);
 }
 
 VALUE locale_with_minimized_subtags(VALUE self)
 {
-    VALUE id = rb_iv_get(self, "@id");
-    int32_t buffer_capa = 64;
-    char* buffer = char_buffer_new(buffer_capa);
-    UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = uloc_minimizeSubtags(RSTRING_PTR(id),
-                                   buffer,
-                                   buffer_capa,
-                                   &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            buffer_capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            char_buffer_resize(buffer, buffer_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            char_buffer_free(buffer);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
-    buffer[len] = '\0';
-
-    VALUE res = locale_new_from_cstr(buffer);
-    char_buffer_free(buffer);
-    return res;
+    return locale_cached_locale(self, LOCALE_MINIMIZED_SUBTAGS, uloc_minimizeSubtags);
 }
 
 void init_icu_locale(void)
@@ -814,6 +682,7 @@ void init_icu_locale(void)
     ID_unknown = rb_intern("unknown");
 
     rb_cICU_Locale = rb_define_class_under(rb_mICU, "Locale", rb_cObject);
+    rb_define_alloc_func(rb_cICU_Locale, locale_alloc);
     rb_define_singleton_method(rb_cICU_Locale, "available", locale_singleton_available, 0);
     rb_define_singleton_method(rb_cICU_Locale, "default", locale_singleton_get_default, 0);
     rb_define_singleton_method(rb_cICU_Locale, "default=", locale_singleton_set_default, 1);
@@ -822,6 +691,8 @@ void init_icu_locale(void)
     rb_define_singleton_method(rb_cICU_Locale, "iso_countries", locale_singleton_iso_countries, 0);
     rb_define_singleton_method(rb_cICU_Locale, "iso_languages", locale_singleton_iso_languages, 0);
     rb_define_method(rb_cICU_Locale, "initialize", locale_initialize, 1);
+    rb_define_method(rb_cICU_Locale, "initialize_copy", locale_initialize_copy, 1);
+    rb_define_method(rb_cICU_Locale, "id", locale_get_id, 0);
     rb_define_method(rb_cICU_Locale, "language_tag", locale_language_tag, -1);
     rb_define_method(rb_cICU_Locale, "lcid", locale_lcid, 0);
     rb_define_method(rb_cICU_Locale, "display_country", locale_display_country, -1);
@@ -846,7 +717,8 @@ void init_icu_locale(void)
     rb_define_method(rb_cICU_Locale, "variant", locale_variant, 0);
     rb_define_method(rb_cICU_Locale, "with_likely_subtags", locale_with_likely_subtags, 0);
     rb_define_method(rb_cICU_Locale, "with_minimized_subtags", locale_with_minimized_subtags, 0);
-
 }
 
+#undef GET_LOCALE
+
 /* vim: set expandtab sws=4 sw=4: */
@@ -1,5 +1,7 @@
 #include "icu.h"
 #include "unicode/unorm2.h"
+#include "unicode/ucnv.h"
+#include <string.h>
 
 #define GET_NORMALIZER(_data) icu_normalizer_data* _data; \
                               TypedData_Get_Struct(self, icu_normalizer_data, &icu_normalizer_type, _data)
@@ -10,6 +12,10 @@ static ID ID_nfkc;
 static ID ID_nfkc_cf;
 static ID ID_compose;
 static ID ID_decompose;
+static ID ID_yes;
+static ID ID_no;
+static ID ID_maybe;
+static ID ID_without_gvl;
 
 typedef struct {
     VALUE rb_instance;
@@ -74,33 +80,537 @@ VALUE normalizer_initialize(int argc, VALUE* argv, VALUE self)
     return self;
 }
 
+#define NORMALIZER_SEGMENT_SIZE 4096
+
+typedef struct {
+    const UNormalizer2* service;
+    const UChar* src;
+    int32_t src_len;
+    int32_t src_offset; // where the next segment starts
+    UChar* dest;
+    int32_t dest_capa;
+    int32_t dest_len; // normalized units of the finished segments
+    int32_t needed; // the capacity the segment which didn't fit asks for
+    UErrorCode status;
+    volatile int interrupted;
+} normalizer_normalize_args;
+
+// cuts at the first normalization boundary past NORMALIZER_SEGMENT_SIZE units
+static int32_t normalizer_segment_end(const UNormalizer2* service, const UChar* src, int32_t start, int32_t len)
+{
+    if (len - start <= NORMALIZER_SEGMENT_SIZE) {
+        return len;
+    }
+    int32_t i = start + NORMALIZER_SEGMENT_SIZE;
+    U16_SET_CP_START(src, start, i);
+    while (i < len) {
+        int32_t boundary = i;
+        UChar32 c;
+        U16_NEXT(src, i, len, c);
+        if (boundary > start && unorm2_hasBoundaryBefore(service, c)) {
+            return boundary;
+        }
+    }
+    return len;
+}
+
+/* Normalizes segment by segment and stops at the one which doesn't fit or when
+   interrupted, the caller grows dest and calls again to resume from that segment. */
+static void* normalizer_normalize_nogvl(void* _args)
+{
+    normalizer_normalize_args* args = _args;
+    while (args->src_offset < args->src_len && !args->interrupted) {
+        int32_t end = normalizer_segment_end(args->service, args->src, args->src_offset, args->src_len);
+        int32_t len = unorm2_normalize(args->service,
+                                       args->src + args->src_offset, end - args->src_offset,
+                                       args->dest + args->dest_len, args->dest_capa - args->dest_len,
+                                       &args->status);
+        if (U_FAILURE(args->status)) {
+            args->needed = args->dest_len + len;
+            return NULL;
+        }
+        args->dest_len += len;
+        args->src_offset = end;
+    }
+    return NULL;
+}
+
+// returns needed as a capacity, raises when it exceeds the int32_t lengths of ICU
+static int32_t normalizer_capa_for(int64_t needed)
+{
+    if (needed > INT32_MAX) {
+        rb_raise(rb_eRangeError, "normalized text is too large");
+    }
+    return (int32_t)needed;
+}
+
+// normalizes src into dest, returns the length of the normalized text
+static int32_t normalizer_normalize_into(const UNormalizer2* service, const UChar* src, int32_t src_len, icu_uscratch* dest)
+{
+    normalizer_normalize_args args;
+    args.service = service;
+    args.src = src;
+    args.src_len = src_len;
+    args.src_offset = 0;
+    args.dest_len = 0;
+    for (;;) {
+        args.dest = dest->ptr;
+        args.dest_capa = dest->capa;
+        args.status = U_ZERO_ERROR;
+        icu_call_without_gvl_resumable_when(args.src_len - args.src_offset, normalizer_normalize_nogvl, &args,
+                                            &args.interrupted);
+        if (args.status == U_BUFFER_OVERFLOW_ERROR) {
+            icu_count_retry(ICU_RETRY_NORMALIZE);
+            dest->len = args.dest_len;
+            int64_t capa = (int64_t)dest->capa * 2;
+            if (capa > INT32_MAX && dest->capa < INT32_MAX) {
+                capa = INT32_MAX;
+            }
+            icu_uscratch_resize(dest, normalizer_capa_for(args.needed > capa ? args.needed : capa));
+        } else if (U_FAILURE(args.status)) {
+            icu_rb_raise_icu_error(args.status);
+        } else {
+            return args.dest_len;
+        }
+    }
+}
+
+// rb_str must be treated as UTF-8
+static inline VALUE normalizer_unchanged_str(VALUE rb_str)
+{
+    // already normalized: the input itself is returned, as the caller passed it
+    if (ENCODING_GET(rb_str) == ICU_RUBY_ENCODING_INDEX) {
+        return rb_str;
+    }
+    return rb_enc_str_new(RSTRING_PTR(rb_str), RSTRING_LEN(rb_str), rb_enc_from_index(ICU_RUBY_ENCODING_INDEX));
+}
+
+#define NORMALIZER_QUICK_CHECK_CAPA 512
+
+/* Tells whether the UTF-8 src is normalized without converting all of it: it's converted
+   piece by piece into a stack buffer, each piece ends before a character with a
+   normalization boundary before it so the pieces can be checked on their own.
+   Returns -1 when it can't tell, for invalid UTF-8 or a piece without any boundary. */
+static int normalizer_utf8_quick_check_yes(const UNormalizer2* service, const char* src, long src_len)
+{
+    UChar buffer[NORMALIZER_QUICK_CHECK_CAPA];
+    while (src_len > 0) {
+        const uint8_t* piece = (const uint8_t*)src;
+        int32_t piece_len = src_len > INT32_MAX ? INT32_MAX : (int32_t)src_len;
+        int32_t i = 0;
+        int32_t len = 0;
+        while (i < piece_len && len <= NORMALIZER_QUICK_CHECK_CAPA - U16_MAX_LENGTH) {
+            UChar32 c;
+            U8_NEXT(piece, i, piece_len, c);
+            if (c < 0) {
+                return -1;
+            }
+            U16_APPEND_UNSAFE(buffer, len, c);
+        }
+        if (i < piece_len) { // the rest of the buffer goes into the next piece
+            int32_t end = len;
+            while (end > 0) {
+                UChar32 c;
+                U16_PREV(buffer, 0, end, c);
+                U8_BACK_1(piece, 0, i);
+                if (end > 0 && unorm2_hasBoundaryBefore(service, c)) {
+                    break;
+                }
+            }
+            if (end == 0) {
+                return -1;
+            }
+            len = end;
+        }
+        UErrorCode status = U_ZERO_ERROR;
+        if (unorm2_spanQuickCheckYes(service, buffer, len, &status) != len || U_FAILURE(status)) {
+            return FALSE;
+        }
+        src += i;
+        src_len -= i;
+    }
+    return TRUE;
+}
+
+/* The UTF-16 buffers are transient C buffers and the result is transcoded
+   straight into the returned Ruby string. The C API has no
+   unorm2_normalizeUTF8, so a UTF-16 pass is needed for UTF-8 too.
+   A UTF-8 str which is already normalized is returned itself, nothing is allocated. */
 VALUE normalizer_normalize(VALUE self, VALUE rb_str)
 {
     StringValue(rb_str);
     GET_NORMALIZER(this);
-    VALUE in = icu_ustring_from_rb_str(rb_str);
-    VALUE out = icu_ustring_init_with_capa_enc(RSTRING_LENINT(rb_str) * 2 + RUBY_C_STRING_TERMINATOR_SIZE, ICU_RUBY_ENCODING_INDEX);
 
+    if (icu_is_rb_str_as_utf_8(rb_str) && icu_is_rb_enc_idx_as_utf_8(ICU_RUBY_ENCODING_INDEX) &&
+        normalizer_utf8_quick_check_yes(this->service, RSTRING_PTR(rb_str), RSTRING_LEN(rb_str)) == TRUE) {
+        return normalizer_unchanged_str(rb_str);
+    }
+
+    icu_uscratch src;
+    icu_uscratch_from_rb_str(&src, rb_str);
     UErrorCode status = U_ZERO_ERROR;
-    int retried = FALSE;
-    int32_t len;
-    do {
-        len = unorm2_normalize(this->service,
-                               icu_ustring_ptr(in), icu_ustring_len(in),
-                               icu_ustring_ptr(out), icu_ustring_capa(out),
-                               &status);
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            icu_ustring_resize(out, len + RUBY_C_STRING_TERMINATOR_SIZE);
+    int32_t span = unorm2_spanQuickCheckYes(this->service, src.ptr, src.len, &status);
+    if (U_SUCCESS(status) && span == src.len) {
+        VALUE result;
+        if (icu_is_rb_str_as_utf_8(rb_str) && icu_is_rb_enc_idx_as_utf_8(ICU_RUBY_ENCODING_INDEX)) {
+            result = normalizer_unchanged_str(rb_str);
+        } else { // already normalized, only the encoding changes
+            result = icu_uchar_to_rb_enc_str(src.ptr, src.len, ICU_RUBY_ENCODING_INDEX);
+        }
+        icu_uscratch_free(&src);
+        return result;
+    }
+
+    icu_uscratch dest;
+    int64_t capa = (int64_t)src.len * 2 + RUBY_C_STRING_TERMINATOR_SIZE;
+    icu_uscratch_init(&dest, capa > INT32_MAX ? INT32_MAX : (int32_t)capa);
+    int32_t len = normalizer_normalize_into(this->service, src.ptr, src.len, &dest);
+    icu_uscratch_free(&src);
+
+    VALUE result = icu_uchar_to_rb_enc_str(dest.ptr, len, ICU_RUBY_ENCODING_INDEX);
+    icu_uscratch_free(&dest);
+    return result;
+}
+
+typedef struct {
+    int32_t src_offset;
+    int32_t src_len;
+    int32_t dest_offset;
+    int32_t dest_len;
+    int unchanged;
+} normalizer_batch_entry;
+
+typedef struct {
+    const UNormalizer2* service;
+    const UChar* src;
+    UChar* dest;
+    int32_t dest_capa;
+    int32_t dest_offset; // the next free slot of dest
+    normalizer_batch_entry* entries;
+    long len;
+    long index; // the next entry to normalize
+    UErrorCode status;
+    volatile int interrupted;
+} normalizer_batch_args;
+
+/* Stops at the first failure or when interrupted. On U_BUFFER_OVERFLOW_ERROR, the
+   caller grows dest and calls again to resume from the entry which didn't fit. */
+static void* normalizer_normalize_batch_nogvl(void* _args)
+{
+    normalizer_batch_args* args = _args;
+    for (; args->index < args->len && !args->interrupted; ++args->index) {
+        normalizer_batch_entry* entry = &args->entries[args->index];
+        const UChar* src = args->src + entry->src_offset;
+        UErrorCode status = U_ZERO_ERROR;
+        int32_t span = unorm2_spanQuickCheckYes(args->service, src, entry->src_len, &status);
+        if (U_SUCCESS(status) && span == entry->src_len) {
+            entry->unchanged = TRUE;
+            continue;
+        }
+        status = U_ZERO_ERROR;
+        entry->dest_offset = args->dest_offset;
+        entry->dest_len = unorm2_normalize(args->service,
+                                           src, entry->src_len,
+                                           args->dest + args->dest_offset, args->dest_capa - args->dest_offset,
+                                           &status);
+        if (U_FAILURE(status)) {
+            args->status = status;
+            break;
+        }
+        args->dest_offset += entry->dest_len;
+    }
+    return NULL;
+}
+
+/* Grows buffer to at least needed units, doubling the requested size to keep the
+   number of resizes low. The whole batch has to fit the int32_t lengths of ICU. */
+static void normalizer_batch_reserve(VALUE buffer, int64_t needed)
+{
+    if (needed > INT32_MAX) {
+        rb_raise(rb_eRangeError, "normalize_all batch is too large, split it");
+    }
+    if (needed <= icu_ustring_capa(buffer)) {
+        return;
+    }
+    int64_t capa = needed * 2;
+    icu_ustring_resize(buffer, capa > INT32_MAX ? INT32_MAX : (int32_t)capa);
+}
+
+/* Normalizes every string of the array, the UTF-16 buffers are shared by all of them.
+   Pass without_gvl: true to release the GVL for the whole batch, otherwise it's
+   released only when the batch is large. */
+VALUE normalizer_normalize_all(int argc, VALUE* argv, VALUE self)
+{
+    VALUE ary;
+    VALUE opts;
+    rb_scan_args(argc, argv, "1:", &ary, &opts);
+    VALUE without_gvl = Qfalse;
+    if (!NIL_P(opts)) {
+        ID keywords[1] = {ID_without_gvl};
+        VALUE values[1];
+        rb_get_kwargs(opts, keywords, 0, 1, values);
+        if (values[0] != Qundef) {
+            without_gvl = values[0];
+        }
+    }
+    ary = rb_convert_type(ary, T_ARRAY, "Array", "to_ary");
+    GET_NORMALIZER(this);
+
+    long len = RARRAY_LEN(ary);
+    VALUE strs = rb_ary_new2(len); // the array itself may change while the GVL is released
+    VALUE entries_buf;
+    normalizer_batch_entry* entries = ALLOCV_N(normalizer_batch_entry, entries_buf, len);
+    VALUE src = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
+    int32_t src_offset = 0;
+    for (long i = 0; i < len; ++i) {
+        VALUE str = rb_ary_entry(ary, i);
+        StringValue(str);
+        rb_ary_push(strs, str);
+
+        // enough for UTF-8, other charsets may need more and are converted again then
+        normalizer_batch_reserve(src, (int64_t)src_offset + RSTRING_LEN(str) + RUBY_C_STRING_TERMINATOR_SIZE);
+        UErrorCode status = U_ZERO_ERROR;
+        entries[i].src_offset = src_offset;
+        entries[i].src_len = icu_rb_str_to_uchar(str,
+                                                 icu_ustring_ptr(src) + src_offset,
+                                                 icu_ustring_capa(src) - src_offset,
+                                                 &status);
+        if (status == U_BUFFER_OVERFLOW_ERROR) {
+            icu_count_retry(ICU_RETRY_USTRING_FROM_RB_STR);
+            normalizer_batch_reserve(src, (int64_t)src_offset + entries[i].src_len + RUBY_C_STRING_TERMINATOR_SIZE);
             status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
+            entries[i].src_len = icu_rb_str_to_uchar(str,
+                                                     icu_ustring_ptr(src) + src_offset,
+                                                     icu_ustring_capa(src) - src_offset,
+                                                     &status);
+        }
+        entries[i].unchanged = FALSE;
+        if (U_FAILURE(status)) {
             icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
         }
-    } while (retried);
+        src_offset += entries[i].src_len;
+    }
 
-    return icu_ustring_to_rb_enc_str_with_len(out, len);
+    VALUE dest = icu_ustring_init_with_capa_enc(64, ICU_RUBY_ENCODING_INDEX);
+    normalizer_batch_reserve(dest, (int64_t)src_offset + 64);
+    normalizer_batch_args args;
+    args.service = this->service;
+    args.src = icu_ustring_ptr(src);
+    args.dest_offset = 0;
+    args.entries = entries;
+    args.len = len;
+    args.index = 0;
+    do {
+        args.dest = icu_ustring_ptr(dest);
+        args.dest_capa = icu_ustring_capa(dest);
+        args.status = U_ZERO_ERROR;
+        icu_call_without_gvl_resumable_when(RTEST(without_gvl) ? LONG_MAX : src_offset,
+                                            normalizer_normalize_batch_nogvl, &args, &args.interrupted);
+        if (args.status == U_BUFFER_OVERFLOW_ERROR) {
+            icu_count_retry(ICU_RETRY_NORMALIZE);
+            normalizer_batch_reserve(dest, (int64_t)args.dest_offset + entries[args.index].dest_len);
+        } else if (U_FAILURE(args.status)) {
+            icu_rb_raise_icu_error(args.status);
+        }
+    } while (args.index < len);
+
+    VALUE result = rb_ary_new2(len);
+    for (long i = 0; i < len; ++i) {
+        VALUE str = RARRAY_AREF(strs, i);
+        if (entries[i].unchanged && icu_is_rb_str_as_utf_8(str)) {
+            rb_ary_push(result, normalizer_unchanged_str(str));
+        } else if (entries[i].unchanged) {
+            rb_ary_push(result, icu_uchar_to_rb_enc_str(icu_ustring_ptr(src) + entries[i].src_offset,
+                                                        entries[i].src_len,
+                                                        ICU_RUBY_ENCODING_INDEX));
+        } else {
+            rb_ary_push(result, icu_uchar_to_rb_enc_str(icu_ustring_ptr(dest) + entries[i].dest_offset,
+                                                        entries[i].dest_len,
+                                                        ICU_RUBY_ENCODING_INDEX));
+        }
+    }
+    ALLOCV_END(entries_buf);
+    RB_GC_GUARD(src);
+    RB_GC_GUARD(dest);
+    return result;
+}
+
+// text without a normalization boundary is held back up to this many chunks
+#define NORMALIZER_STREAM_MAX_PENDING_CHUNKS 16
+
+typedef struct {
+    icu_stream stream;
+    const icu_normalizer_data* this;
+    const char* converter_name;
+    UConverter* converter;
+    VALUE pending; // decoded text which isn't normalized yet
+    int32_t pending_len;
+    int32_t max_pending; // the capacity pending may grow to
+    icu_uscratch dest;
+} normalizer_stream_state;
+
+// returns the index of the last normalization boundary or 0 when there's none
+static int32_t normalizer_last_boundary(const UNormalizer2* service, const UChar* text, int32_t len)
+{
+    int32_t i = len;
+    while (i > 0) {
+        UChar32 c;
+        U16_PREV(text, 0, i, c);
+        if (i > 0 && unorm2_hasBoundaryBefore(service, c)) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void normalizer_stream_decode(normalizer_stream_state* state, VALUE chunk, int flush)
+{
+    const char* source = NIL_P(chunk) ? NULL : RSTRING_PTR(chunk);
+    const char* source_limit = NIL_P(chunk) ? NULL : RSTRING_END(chunk);
+    // a unit rarely needs more than a byte, the converter may hold a few units back
+    int64_t needed = (int64_t)state->pending_len + (source_limit - source) + 16;
+    if (needed > state->max_pending) {
+        rb_raise(rb_eICU_Error, "no normalization boundary within %d units of the stream", state->max_pending);
+    }
+    if (needed > icu_ustring_capa(state->pending)) {
+        icu_ustring_resize(state->pending, (int32_t)needed);
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    do {
+        UChar* target = icu_ustring_ptr(state->pending) + state->pending_len;
+        UChar* target_start = target;
+        status = U_ZERO_ERROR;
+        ucnv_toUnicode(state->converter,
+                       &target, icu_ustring_ptr(state->pending) + icu_ustring_capa(state->pending),
+                       &source, source_limit,
+                       NULL, flush, &status);
+        state->pending_len += (int32_t)(target - target_start);
+        if (status == U_BUFFER_OVERFLOW_ERROR) { // continues where it stopped
+            if (icu_ustring_capa(state->pending) >= state->max_pending) {
+                rb_raise(rb_eICU_Error, "no normalization boundary within %d units of the stream", state->max_pending);
+            }
+            int64_t capa = (int64_t)icu_ustring_capa(state->pending) * 2;
+            icu_ustring_resize(state->pending, capa > state->max_pending ? state->max_pending : (int32_t)capa);
+        }
+    } while (status == U_BUFFER_OVERFLOW_ERROR);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+}
+
+// normalizes the first len units of the pending text and writes them out
+static void normalizer_stream_flush(normalizer_stream_state* state, int32_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    int32_t normalized_len = normalizer_normalize_into(state->this->service,
+                                                       icu_ustring_ptr(state->pending), len,
+                                                       &state->dest);
+    icu_stream_write(&state->stream, icu_uchar_to_rb_enc_str(state->dest.ptr, normalized_len, ICU_RUBY_ENCODING_INDEX));
+
+    state->pending_len -= len;
+    memmove(icu_ustring_ptr(state->pending),
+            icu_ustring_ptr(state->pending) + len,
+            sizeof(UChar) * state->pending_len);
+}
+
+static void normalizer_stream_process(icu_stream* stream, VALUE chunk)
+{
+    normalizer_stream_state* state = (normalizer_stream_state*)stream;
+    normalizer_stream_decode(state, chunk, NIL_P(chunk));
+    if (NIL_P(chunk)) {
+        normalizer_stream_flush(state, state->pending_len);
+    } else {
+        normalizer_stream_flush(state,
+                                normalizer_last_boundary(state->this->service,
+                                                         icu_ustring_ptr(state->pending),
+                                                         state->pending_len));
+    }
+}
+
+static void normalizer_stream_close(icu_stream* stream)
+{
+    normalizer_stream_state* state = (normalizer_stream_state*)stream;
+    icu_converter_give_back(state->converter_name, state->converter);
+}
+
+/* Reads io_in by chunks and writes the normalized text to io_out, returns the bytes written.
+   The text is cut at normalization boundaries so the memory stays bounded by the chunk size.
+   Text without any boundary, like a long run of combining marks, is held back for up to
+   16 chunks of at least 65536 units and raises ICU::Error beyond that.
+   The input is decoded as the external encoding of io_in, invalid input raises ICU::Error. */
+VALUE normalizer_normalize_stream(int argc, VALUE* argv, VALUE self)
+{
+    GET_NORMALIZER(this);
+    normalizer_stream_state state;
+    icu_stream_init(&state.stream, argc, argv);
+    state.stream.process = normalizer_stream_process;
+    state.stream.close = normalizer_stream_close;
+    state.this = this;
+
+    long chunk_size = state.stream.chunk_size;
+    int64_t max_pending = (int64_t)(chunk_size < ICU_STREAM_CHUNK_SIZE ? ICU_STREAM_CHUNK_SIZE : chunk_size) *
+                          NORMALIZER_STREAM_MAX_PENDING_CHUNKS;
+    state.max_pending = max_pending > INT32_MAX ? INT32_MAX : (int32_t)max_pending;
+    state.pending = icu_ustring_init_with_capa_enc((int32_t)chunk_size + 16, ICU_RUBY_ENCODING_INDEX);
+    state.pending_len = 0;
+    icu_uscratch_init(&state.dest, (int32_t)chunk_size * 2);
+
+    state.converter_name = icu_converter_name_for_enc_idx(icu_stream_external_enc_idx(&state.stream));
+    state.converter = icu_converter_borrow(state.converter_name);
+    // invalid input raises as it does with normalize instead of turning into U+FFFD
+    UErrorCode status = U_ZERO_ERROR;
+    ucnv_setToUCallBack(state.converter, UCNV_TO_U_CALLBACK_STOP, NULL, NULL, NULL, &status);
+    if (U_FAILURE(status)) {
+        normalizer_stream_close(&state.stream);
+        icu_rb_raise_icu_error(status);
+    }
+
+    icu_stream_run(&state.stream);
+    icu_uscratch_free(&state.dest);
+    RB_GC_GUARD(state.pending);
+    return SIZET2NUM(state.stream.written);
+}
+
+VALUE normalizer_is_normalized(VALUE self, VALUE rb_str)
+{
+    StringValue(rb_str);
+    GET_NORMALIZER(this);
+    icu_uscratch in;
+    icu_uscratch_from_rb_str(&in, rb_str);
+
+    UErrorCode status = U_ZERO_ERROR;
+    UBool result = unorm2_isNormalized(this->service, in.ptr, in.len, &status);
+    icu_uscratch_free(&in);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return result ? Qtrue : Qfalse;
+}
+
+/* Faster than normalized? but may answer :maybe for composing normalizers. */
+VALUE normalizer_quick_check(VALUE self, VALUE rb_str)
+{
+    StringValue(rb_str);
+    GET_NORMALIZER(this);
+    icu_uscratch in;
+    icu_uscratch_from_rb_str(&in, rb_str);
+
+    UErrorCode status = U_ZERO_ERROR;
+    UNormalizationCheckResult result = unorm2_quickCheck(this->service, in.ptr, in.len, &status);
+    icu_uscratch_free(&in);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    switch (result) {
+    case UNORM_YES:
+        return ID2SYM(ID_yes);
+    case UNORM_NO:
+        return ID2SYM(ID_no);
+    case UNORM_MAYBE: default:
+        return ID2SYM(ID_maybe);
+    }
 }
 
 void init_icu_normalizer(void)
@@ -110,13 +620,23 @@ void init_icu_normalizer(void)
     ID_nfkc_cf = rb_intern("nfkc_cf");
     ID_compose = rb_intern("compose");
     ID_decompose = rb_intern("decompose");
+    ID_without_gvl = rb_intern("without_gvl");
+    ID_yes = rb_intern("yes");
+    ID_no = rb_intern("no");
+    ID_maybe = rb_intern("maybe");
 
     rb_cICU_Normalizer = rb_define_class_under(rb_mICU, "Normalizer", rb_cObject);
     rb_define_alloc_func(rb_cICU_Normalizer, normalizer_alloc);
     rb_define_method(rb_cICU_Normalizer, "initialize", normalizer_initialize, -1);
     rb_define_method(rb_cICU_Normalizer, "normalize", normalizer_normalize, 1);
+    rb_define_method(rb_cICU_Normalizer, "normalize_all", normalizer_normalize_all, -1);
+    rb_define_method(rb_cICU_Normalizer, "normalize_stream", normalizer_normalize_stream, -1);
+    rb_define_method(rb_cICU_Normalizer, "normalized?", normalizer_is_normalized, 1);
+    rb_define_method(rb_cICU_Normalizer, "quick_check", normalizer_quick_check, 1);
 }
 
+#undef NORMALIZER_STREAM_MAX_PENDING_CHUNKS
+#undef NORMALIZER_SEGMENT_SIZE
 #undef GET_NORMALIZER
 
 /* vim: set expandtab sws=4 sw=4: */
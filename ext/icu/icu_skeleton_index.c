@@ -0,0 +1,542 @@
+#include "icu.h"
+#include "unicode/uspoof.h"
+#include "unicode/uversion.h"
+#include <stdio.h>
+#include <string.h>
+
+#define GET_SKELETON_INDEX(_data) icu_skeleton_index_data* _data; \
+                                  TypedData_Get_Struct(self, icu_skeleton_index_data, &icu_skeleton_index_type, _data)
+
+VALUE rb_cICU_SpoofChecker_SkeletonIndex;
+
+#define SKELETON_INDEX_MIN_CAPA 16
+#define SKELETON_INDEX_FORMAT 1
+#define SKELETON_INDEX_BYTE_ORDER 0x01020304
+static const char k_skeleton_index_magic[8] = "ICUSKIX";
+
+/* Names are kept with the 64-bit hash of their skeleton in an open addressing table.
+   A lookup computes one skeleton and probes the table, names sharing the hash are
+   reported as confusable, a false match is about as likely as size / 2^64.
+   Adding names takes the lock, as save reads the arrays without the GVL. lookup and
+   confusable? don't: they only read, with the GVL held, and adding a name never calls
+   Ruby or gives up the GVL between the first change of the arrays and the last. */
+typedef struct {
+    VALUE rb_instance;
+    VALUE checker; // computes the skeletons
+    VALUE lock; // save runs without the GVL, adding names has to wait for it
+    uint64_t* hashes; // of the skeleton of each name
+    uint64_t* name_ends; // name i ends at name_ends[i] in names and starts where name i - 1 ends
+    char* names; // the UTF-8 names one after the other
+    size_t len;
+    size_t capa; // of hashes and name_ends
+    size_t names_len;
+    size_t names_capa;
+    uint32_t* slots; // index + 1 into hashes, 0 is an empty slot
+    size_t slots_capa; // a power of 2
+} icu_skeleton_index_data;
+
+typedef struct {
+    char magic[8];
+    uint32_t format;
+    uint32_t byte_order; // files are written in the native byte order
+    char icu_version[U_MAX_VERSION_STRING_LENGTH]; // skeletons change with the ICU data
+    uint64_t len;
+    uint64_t names_len;
+} skeleton_index_header;
+
+static void skeleton_index_mark(void* _this)
+{
+    icu_skeleton_index_data* this = _this;
+    rb_gc_mark(this->checker);
+    rb_gc_mark(this->lock);
+}
+
+static void skeleton_index_free(void* _this)
+{
+    icu_skeleton_index_data* this = _this;
+    ruby_xfree(this->hashes);
+    ruby_xfree(this->name_ends);
+    ruby_xfree(this->names);
+    ruby_xfree(this->slots);
+}
+
+static size_t skeleton_index_memsize(const void* _this)
+{
+    const icu_skeleton_index_data* this = _this;
+    return sizeof(icu_skeleton_index_data) +
+           (sizeof(uint64_t) * 2) * this->capa +
+           this->names_capa +
+           sizeof(uint32_t) * this->slots_capa;
+}
+
+static const rb_data_type_t icu_skeleton_index_type = {
+    "icu/spoof_checker/skeleton_index",
+    {skeleton_index_mark, skeleton_index_free, skeleton_index_memsize,},
+    0, 0,
+    RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+VALUE skeleton_index_alloc(VALUE self)
+{
+    icu_skeleton_index_data* this;
+    return TypedData_Make_Struct(self, icu_skeleton_index_data, &icu_skeleton_index_type, this);
+}
+
+/* Creates an empty index, the skeletons are computed by checker or a new SpoofChecker. */
+VALUE skeleton_index_initialize(int argc, VALUE* argv, VALUE self)
+{
+    VALUE checker;
+    rb_scan_args(argc, argv, "01", &checker);
+    if (NIL_P(checker)) {
+        checker = rb_class_new_instance(0, NULL, rb_cICU_SpoofChecker);
+    }
+    icu_spoof_checker_service(checker); // raises unless it is a SpoofChecker
+
+    GET_SKELETON_INDEX(this);
+    this->rb_instance = self;
+    this->checker = checker;
+    this->lock = rb_mutex_new();
+    return self;
+}
+
+// FNV-1a, which doesn't depend on the process so saved indexes stay valid
+static uint64_t skeleton_index_hash(const UChar* ptr, int32_t len)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int32_t i = 0; i < len; ++i) {
+        hash = (hash ^ (ptr[i] & 0xff)) * 0x100000001b3ULL;
+        hash = (hash ^ (ptr[i] >> 8)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static inline size_t skeleton_index_slot_of(const icu_skeleton_index_data* this, uint64_t hash)
+{
+    return (size_t)(hash ^ (hash >> 31)) & (this->slots_capa - 1);
+}
+
+static void skeleton_index_slot_insert(icu_skeleton_index_data* this, size_t index)
+{
+    size_t slot = skeleton_index_slot_of(this, this->hashes[index]);
+    while (this->slots[slot] != 0) {
+        slot = (slot + 1) & (this->slots_capa - 1);
+    }
+    this->slots[slot] = (uint32_t)(index + 1);
+}
+
+// makes room for extra more names, the table stays at most 3/4 full
+static void skeleton_index_reserve(icu_skeleton_index_data* this, size_t extra, size_t extra_names_len)
+{
+    size_t len = this->len + extra;
+    if (len >= UINT32_MAX) {
+        rb_raise(rb_eRangeError, "too many names for a skeleton index");
+    }
+    if (len > this->capa) {
+        size_t capa = this->capa < SKELETON_INDEX_MIN_CAPA ? SKELETON_INDEX_MIN_CAPA : this->capa;
+        while (capa < len) {
+            capa *= 2;
+        }
+        REALLOC_N(this->hashes, uint64_t, capa);
+        REALLOC_N(this->name_ends, uint64_t, capa);
+        this->capa = capa;
+    }
+    size_t names_len = this->names_len + extra_names_len;
+    if (names_len > this->names_capa) {
+        size_t names_capa = this->names_capa < 256 ? 256 : this->names_capa;
+        while (names_capa < names_len) {
+            names_capa *= 2;
+        }
+        REALLOC_N(this->names, char, names_capa);
+        this->names_capa = names_capa;
+    }
+    if (len * 4 > this->slots_capa * 3) {
+        size_t slots_capa = this->slots_capa < SKELETON_INDEX_MIN_CAPA ? SKELETON_INDEX_MIN_CAPA : this->slots_capa;
+        while (len * 4 > slots_capa * 3) {
+            slots_capa *= 2;
+        }
+        // a failed allocation raises before anything changes
+        uint32_t* slots = ZALLOC_N(uint32_t, slots_capa);
+        ruby_xfree(this->slots);
+        this->slots = slots;
+        this->slots_capa = slots_capa;
+        for (size_t i = 0; i < this->len; ++i) {
+            skeleton_index_slot_insert(this, i);
+        }
+    }
+}
+
+// skeleton and in are reused across calls
+static uint64_t skeleton_index_skeleton_hash(const icu_skeleton_index_data* this, VALUE str,
+                                             icu_uscratch* in, icu_uscratch* skeleton)
+{
+    icu_uscratch_from_rb_str(in, str);
+    int32_t len = icu_spoof_skeleton(icu_spoof_checker_service(this->checker), in, skeleton);
+    icu_uscratch_free(in);
+    return skeleton_index_hash(skeleton->ptr, len);
+}
+
+static inline const char* skeleton_index_name_ptr(const icu_skeleton_index_data* this, size_t index)
+{
+    return this->names + (index == 0 ? 0 : this->name_ends[index - 1]);
+}
+
+static inline size_t skeleton_index_name_len(const icu_skeleton_index_data* this, size_t index)
+{
+    return this->name_ends[index] - (index == 0 ? 0 : this->name_ends[index - 1]);
+}
+
+static void skeleton_index_add_internal(icu_skeleton_index_data* this, VALUE name,
+                                        icu_uscratch* in, icu_uscratch* skeleton)
+{
+    StringValue(name);
+    uint64_t hash = skeleton_index_skeleton_hash(this, name, in, skeleton);
+    VALUE utf8 = rb_str_export_to_enc(name, rb_utf8_encoding());
+    size_t len = RSTRING_LEN(utf8);
+
+    skeleton_index_reserve(this, 1, len);
+    // the same name is only kept once
+    size_t slot = skeleton_index_slot_of(this, hash);
+    for (; this->slots[slot] != 0; slot = (slot + 1) & (this->slots_capa - 1)) {
+        size_t index = this->slots[slot] - 1;
+        if (this->hashes[index] == hash && skeleton_index_name_len(this, index) == len &&
+            memcmp(skeleton_index_name_ptr(this, index), RSTRING_PTR(utf8), len) == 0) {
+            return;
+        }
+    }
+    memcpy(this->names + this->names_len, RSTRING_PTR(utf8), len);
+    this->names_len += len;
+    this->hashes[this->len] = hash;
+    this->name_ends[this->len] = this->names_len;
+    this->slots[slot] = (uint32_t)(this->len + 1);
+    this->len++;
+    RB_GC_GUARD(utf8);
+}
+
+typedef struct {
+    icu_skeleton_index_data* this;
+    VALUE names; // a String or an Array of them
+} skeleton_index_add_args;
+
+static VALUE skeleton_index_add_locked(VALUE _args)
+{
+    skeleton_index_add_args* args = (skeleton_index_add_args*)_args;
+    icu_uscratch in;
+    icu_uscratch skeleton;
+    icu_uscratch_init(&skeleton, ICU_USCRATCH_INLINE_CAPA);
+    if (RB_TYPE_P(args->names, T_ARRAY)) {
+        // the slots are sized once, the other arrays grow geometrically anyway
+        skeleton_index_reserve(args->this, RARRAY_LEN(args->names), 0);
+        for (long i = 0; i < RARRAY_LEN(args->names); ++i) {
+            skeleton_index_add_internal(args->this, rb_ary_entry(args->names, i), &in, &skeleton);
+        }
+    } else {
+        skeleton_index_add_internal(args->this, args->names, &in, &skeleton);
+    }
+    icu_uscratch_free(&skeleton);
+    return Qnil;
+}
+
+/* Adds name to the index, a name already in it is kept once. */
+VALUE skeleton_index_add(VALUE self, VALUE name)
+{
+    StringValue(name);
+    GET_SKELETON_INDEX(this);
+
+    skeleton_index_add_args args;
+    args.this = this;
+    args.names = name;
+    rb_mutex_synchronize(this->lock, skeleton_index_add_locked, (VALUE)&args);
+    return self;
+}
+
+/* Adds the Strings in names, like add with each of them. */
+VALUE skeleton_index_concat(VALUE self, VALUE names)
+{
+    Check_Type(names, T_ARRAY);
+    GET_SKELETON_INDEX(this);
+
+    skeleton_index_add_args args;
+    args.this = this;
+    args.names = names;
+    rb_mutex_synchronize(this->lock, skeleton_index_add_locked, (VALUE)&args);
+    return self;
+}
+
+/* Builds an index of the Strings in names at once. */
+VALUE skeleton_index_build(int argc, VALUE* argv, VALUE klass)
+{
+    VALUE names;
+    VALUE checker;
+    rb_scan_args(argc, argv, "11", &names, &checker);
+    Check_Type(names, T_ARRAY);
+    VALUE self = rb_class_new_instance(NIL_P(checker) ? 0 : 1, &checker, klass);
+    return skeleton_index_concat(self, names);
+}
+
+/* Returns the names of the index which are confusable with str, in the order they were added. */
+VALUE skeleton_index_lookup(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_SKELETON_INDEX(this);
+
+    VALUE result = rb_ary_new();
+    if (this->len == 0) {
+        return result;
+    }
+    icu_uscratch in;
+    icu_uscratch skeleton;
+    icu_uscratch_init(&skeleton, ICU_USCRATCH_INLINE_CAPA);
+    uint64_t hash = skeleton_index_skeleton_hash(this, str, &in, &skeleton);
+    icu_uscratch_free(&skeleton);
+
+    for (size_t slot = skeleton_index_slot_of(this, hash);
+         this->slots[slot] != 0;
+         slot = (slot + 1) & (this->slots_capa - 1)) {
+        size_t index = this->slots[slot] - 1;
+        if (this->hashes[index] == hash) {
+            rb_ary_push(result, SIZET2NUM(index));
+        }
+    }
+    // probing order isn't insertion order, few names share a skeleton
+    if (RARRAY_LEN(result) > 1) {
+        rb_ary_sort_bang(result);
+    }
+    for (long i = 0; i < RARRAY_LEN(result); ++i) {
+        size_t index = NUM2SIZET(RARRAY_AREF(result, i));
+        rb_ary_store(result, i, rb_enc_str_new(skeleton_index_name_ptr(this, index),
+                                               skeleton_index_name_len(this, index),
+                                               rb_utf8_encoding()));
+    }
+    return result;
+}
+
+/* Returns true when str is confusable with a name of the index. */
+VALUE skeleton_index_confusable(VALUE self, VALUE str)
+{
+    StringValue(str);
+    GET_SKELETON_INDEX(this);
+
+    if (this->len == 0) {
+        return Qfalse;
+    }
+    icu_uscratch in;
+    icu_uscratch skeleton;
+    icu_uscratch_init(&skeleton, ICU_USCRATCH_INLINE_CAPA);
+    uint64_t hash = skeleton_index_skeleton_hash(this, str, &in, &skeleton);
+    icu_uscratch_free(&skeleton);
+
+    for (size_t slot = skeleton_index_slot_of(this, hash);
+         this->slots[slot] != 0;
+         slot = (slot + 1) & (this->slots_capa - 1)) {
+        if (this->hashes[this->slots[slot] - 1] == hash) {
+            return Qtrue;
+        }
+    }
+    return Qfalse;
+}
+
+VALUE skeleton_index_size(VALUE self)
+{
+    GET_SKELETON_INDEX(this);
+    return SIZET2NUM(this->len);
+}
+
+VALUE skeleton_index_checker(VALUE self)
+{
+    GET_SKELETON_INDEX(this);
+    return this->checker;
+}
+
+typedef struct {
+    FILE* file;
+    void* ptr;
+    size_t size;
+    size_t done;
+    int write;
+} skeleton_index_io_args;
+
+static void* skeleton_index_io_nogvl(void* _args)
+{
+    skeleton_index_io_args* args = _args;
+    if (args->write) {
+        args->done = fwrite(args->ptr, 1, args->size, args->file);
+    } else {
+        args->done = fread(args->ptr, 1, args->size, args->file);
+    }
+    return NULL;
+}
+
+// returns FALSE when not all of size bytes could be transferred
+static int skeleton_index_io(FILE* file, void* ptr, size_t size, int write)
+{
+    skeleton_index_io_args args;
+    args.file = file;
+    args.ptr = ptr;
+    args.size = size;
+    args.done = 0;
+    args.write = write;
+    icu_call_without_gvl_when((long)size, skeleton_index_io_nogvl, &args);
+    return args.done == size;
+}
+
+static void skeleton_index_icu_version(char* dest)
+{
+    UVersionInfo version;
+    u_getVersion(version);
+    u_versionToString(version, dest);
+}
+
+typedef struct {
+    icu_skeleton_index_data* this;
+    VALUE path;
+    FILE* file;
+} skeleton_index_file_args;
+
+static VALUE skeleton_index_file_close(VALUE _args)
+{
+    skeleton_index_file_args* args = (skeleton_index_file_args*)_args;
+    if (args->file != NULL) {
+        fclose(args->file);
+        args->file = NULL;
+    }
+    return Qnil;
+}
+
+static VALUE skeleton_index_save_locked(VALUE _args)
+{
+    skeleton_index_file_args* args = (skeleton_index_file_args*)_args;
+    icu_skeleton_index_data* this = args->this;
+
+    skeleton_index_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, k_skeleton_index_magic, sizeof(header.magic));
+    header.format = SKELETON_INDEX_FORMAT;
+    header.byte_order = SKELETON_INDEX_BYTE_ORDER;
+    skeleton_index_icu_version(header.icu_version);
+    header.len = this->len;
+    header.names_len = this->names_len;
+
+    args->file = fopen(StringValueCStr(args->path), "wb");
+    if (args->file == NULL) {
+        rb_sys_fail_str(args->path);
+    }
+    // the table is rebuilt on load, only the names and their hashes are written
+    if (!skeleton_index_io(args->file, &header, sizeof(header), TRUE) ||
+        !skeleton_index_io(args->file, this->hashes, sizeof(uint64_t) * this->len, TRUE) ||
+        !skeleton_index_io(args->file, this->name_ends, sizeof(uint64_t) * this->len, TRUE) ||
+        !skeleton_index_io(args->file, this->names, this->names_len, TRUE) ||
+        fflush(args->file) != 0) {
+        rb_sys_fail_str(args->path);
+    }
+    int closed = fclose(args->file) == 0;
+    args->file = NULL;
+    if (!closed) {
+        rb_sys_fail_str(args->path);
+    }
+    return Qnil;
+}
+
+static VALUE skeleton_index_save_run(VALUE _args)
+{
+    skeleton_index_file_args* args = (skeleton_index_file_args*)_args;
+    return rb_mutex_synchronize(args->this->lock, skeleton_index_save_locked, _args);
+}
+
+/* Writes the index to a compact binary file at path, only readable by load
+   on a machine of the same byte order with the same ICU version. */
+VALUE skeleton_index_save(VALUE self, VALUE path)
+{
+    FilePathValue(path);
+    GET_SKELETON_INDEX(this);
+
+    skeleton_index_file_args args;
+    args.this = this;
+    args.path = path;
+    args.file = NULL;
+    rb_ensure(skeleton_index_save_run, (VALUE)&args, skeleton_index_file_close, (VALUE)&args);
+    return self;
+}
+
+static VALUE skeleton_index_load_run(VALUE _args)
+{
+    skeleton_index_file_args* args = (skeleton_index_file_args*)_args;
+    icu_skeleton_index_data* this = args->this;
+
+    args->file = fopen(StringValueCStr(args->path), "rb");
+    if (args->file == NULL) {
+        rb_sys_fail_str(args->path);
+    }
+    skeleton_index_header header;
+    if (!skeleton_index_io(args->file, &header, sizeof(header), FALSE) ||
+        memcmp(header.magic, k_skeleton_index_magic, sizeof(header.magic)) != 0 ||
+        header.format != SKELETON_INDEX_FORMAT ||
+        header.byte_order != SKELETON_INDEX_BYTE_ORDER) {
+        rb_raise(rb_eICU_Error, "%"PRIsVALUE" isn't a skeleton index", args->path);
+    }
+    char icu_version[U_MAX_VERSION_STRING_LENGTH];
+    skeleton_index_icu_version(icu_version);
+    header.icu_version[U_MAX_VERSION_STRING_LENGTH - 1] = '\0';
+    if (strcmp(header.icu_version, icu_version) != 0) {
+        rb_raise(rb_eICU_Error, "%"PRIsVALUE" has skeletons of ICU %s, not of ICU %s",
+                 args->path, header.icu_version, icu_version);
+    }
+
+    skeleton_index_reserve(this, (size_t)header.len, (size_t)header.names_len);
+    if (!skeleton_index_io(args->file, this->hashes, sizeof(uint64_t) * header.len, FALSE) ||
+        !skeleton_index_io(args->file, this->name_ends, sizeof(uint64_t) * header.len, FALSE) ||
+        !skeleton_index_io(args->file, this->names, header.names_len, FALSE)) {
+        rb_raise(rb_eICU_Error, "%"PRIsVALUE" is truncated", args->path);
+    }
+    uint64_t end = 0;
+    for (size_t i = 0; i < header.len; ++i) {
+        if (this->name_ends[i] < end || this->name_ends[i] > header.names_len) {
+            rb_raise(rb_eICU_Error, "%"PRIsVALUE" is corrupted", args->path);
+        }
+        end = this->name_ends[i];
+    }
+    this->len = header.len;
+    this->names_len = header.names_len;
+    for (size_t i = 0; i < this->len; ++i) {
+        skeleton_index_slot_insert(this, i);
+    }
+    return Qnil;
+}
+
+/* Reads an index written by save, checker computes the skeletons of lookups. */
+VALUE skeleton_index_load(int argc, VALUE* argv, VALUE klass)
+{
+    VALUE path;
+    VALUE checker;
+    rb_scan_args(argc, argv, "11", &path, &checker);
+    FilePathValue(path);
+    VALUE self = rb_class_new_instance(NIL_P(checker) ? 0 : 1, &checker, klass);
+    GET_SKELETON_INDEX(this);
+
+    skeleton_index_file_args args;
+    args.this = this;
+    args.path = path;
+    args.file = NULL;
+    rb_ensure(skeleton_index_load_run, (VALUE)&args, skeleton_index_file_close, (VALUE)&args);
+    return self;
+}
+
+void init_icu_skeleton_index(void)
+{
+    rb_cICU_SpoofChecker_SkeletonIndex = rb_define_class_under(rb_cICU_SpoofChecker, "SkeletonIndex", rb_cObject);
+    rb_define_alloc_func(rb_cICU_SpoofChecker_SkeletonIndex, skeleton_index_alloc);
+    rb_define_singleton_method(rb_cICU_SpoofChecker_SkeletonIndex, "build", skeleton_index_build, -1);
+    rb_define_singleton_method(rb_cICU_SpoofChecker_SkeletonIndex, "load", skeleton_index_load, -1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "initialize", skeleton_index_initialize, -1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "add", skeleton_index_add, 1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "<<", skeleton_index_add, 1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "concat", skeleton_index_concat, 1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "lookup", skeleton_index_lookup, 1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "confusable?", skeleton_index_confusable, 1);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "size", skeleton_index_size, 0);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "checker", skeleton_index_checker, 0);
+    rb_define_method(rb_cICU_SpoofChecker_SkeletonIndex, "save", skeleton_index_save, 1);
+}
+
+#undef GET_SKELETON_INDEX
+
+/* vim: set expandtab sws=4 sw=4: */
@@ -1,21 +1,50 @@
 #include "icu.h"
 #include "unicode/uspoof.h"
+#include "unicode/uset.h"
+#ifdef HAVE_RUBY_RACTOR_H
+#include "ruby/ractor.h"
+#endif
+
+#ifndef RUBY_TYPED_FROZEN_SHAREABLE
+#define RUBY_TYPED_FROZEN_SHAREABLE 0
+#endif
 
 #define GET_SPOOF_CHECKER(_data) icu_spoof_checker_data* _data; \
                                  TypedData_Get_Struct(self, icu_spoof_checker_data, &icu_spoof_checker_type, _data)
 
 VALUE rb_cICU_SpoofChecker;
+VALUE rb_cICU_SpoofChecker_CheckResult;
 VALUE rb_mChecks;
 VALUE rb_mRestrictionLevel;
 
+static ID ID_thread_spoof_checkers;
+static ID ID_checks;
+static ID ID_level;
+static ID ID_allowed_locales;
+static ID ID_allowed_chars;
+
+/* Frozen spoof checkers by profile name, SpoofChecker.profile hands out clones of them.
+   Only touched from the main Ractor. */
+static VALUE spoof_checker_profiles = Qnil;
+// the options each profile was defined with, as a frozen Array
+static VALUE spoof_checker_profile_options = Qnil;
+#ifdef HAVE_RUBY_RACTOR_H
+// only set in the main Ractor, the C API doesn't tell which one runs
+static rb_ractor_local_key_t spoof_checker_main_ractor_key;
+#endif
+
 typedef struct {
     VALUE rb_instance;
     USpoofChecker* service;
+    USpoofCheckResult* check_result; // reused by check_details, opened on its first call
 } icu_spoof_checker_data;
 
 static void spoof_checker_free(void* _this)
 {
     icu_spoof_checker_data* this = _this;
+    if (this->check_result != NULL) {
+        uspoof_closeCheckResult(this->check_result);
+    }
     uspoof_close(this->service);
 }
 
@@ -28,9 +57,28 @@ static const rb_data_type_t icu_spoof_checker_type = {
     "icu/spoof_checker",
     {NULL, spoof_checker_free, spoof_checker_memsize,},
     0, 0,
-    RUBY_TYPED_FREE_IMMEDIATELY,
+    RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE,
 };
 
+static inline int spoof_checker_in_main_ractor(void)
+{
+#ifdef HAVE_RUBY_RACTOR_H
+    return rb_ractor_local_storage_ptr(spoof_checker_main_ractor_key) != NULL;
+#else
+    return TRUE;
+#endif
+}
+
+// The converters of internal_encoding.c are shared without a lock, strings which aren't
+// UTF-8 are converted by Ruby instead when the checker runs in another Ractor.
+static inline VALUE spoof_checker_ractor_str(VALUE str)
+{
+    if (!icu_is_rb_str_as_utf_8(str) && !spoof_checker_in_main_ractor()) {
+        return rb_str_encode(str, rb_enc_from_encoding(rb_utf8_encoding()), 0, Qnil);
+    }
+    return str;
+}
+
 VALUE spoof_checker_alloc(VALUE self)
 {
     icu_spoof_checker_data* this;
@@ -42,6 +90,7 @@ VALUE spoof_checker_initialize(VALUE self)
     GET_SPOOF_CHECKER(this);
     this->rb_instance = self;
     this->service = FALSE;
+    this->check_result = NULL;
 
     UErrorCode status = U_ZERO_ERROR;
     this->service = uspoof_open(&status);
@@ -66,6 +115,7 @@ VALUE spoof_checker_get_restriction_level(VALUE self)
 
 VALUE spoof_checker_set_restriction_level(VALUE self, VALUE level)
 {
+    rb_check_frozen(self);
     GET_SPOOF_CHECKER(this);
     uspoof_setRestrictionLevel(this->service, NUM2INT(level));
     return spoof_checker_get_restriction_level_internal(this);
@@ -89,6 +139,7 @@ VALUE spoof_checker_get_checks(VALUE self)
 
 VALUE spoof_checker_set_checks(VALUE self, VALUE checks)
 {
+    rb_check_frozen(self);
     GET_SPOOF_CHECKER(this);
 
     UErrorCode status = U_ZERO_ERROR;
@@ -103,40 +154,62 @@ VALUE spoof_checker_confusable(VALUE self, VALUE str_a, VALUE str_b)
 {
     StringValue(str_a);
     StringValue(str_b);
+    str_a = spoof_checker_ractor_str(str_a);
+    str_b = spoof_checker_ractor_str(str_b);
     GET_SPOOF_CHECKER(this);
 
-    VALUE tmp_a = icu_ustring_from_rb_str(str_a);
-    VALUE tmp_b = icu_ustring_from_rb_str(str_b);
     UErrorCode status = U_ZERO_ERROR;
-    int32_t result = uspoof_areConfusable(this->service,
-                                          icu_ustring_ptr(tmp_a),
-                                          icu_ustring_len(tmp_a),
-                                          icu_ustring_ptr(tmp_b),
-                                          icu_ustring_len(tmp_b),
+    int32_t result = 0;
+    if (icu_is_rb_str_as_utf_8(str_a) && icu_is_rb_str_as_utf_8(str_b)) {
+        result = uspoof_areConfusableUTF8(this->service,
+                                          RSTRING_PTR(str_a),
+                                          RSTRING_LENINT(str_a),
+                                          RSTRING_PTR(str_b),
+                                          RSTRING_LENINT(str_b),
                                           &status);
+    } else {
+        icu_uscratch tmp_a;
+        icu_uscratch tmp_b;
+        icu_uscratch_from_rb_str(&tmp_a, str_a);
+        icu_uscratch_from_rb_str(&tmp_b, str_b);
+        result = uspoof_areConfusable(this->service,
+                                      tmp_a.ptr,
+                                      tmp_a.len,
+                                      tmp_b.ptr,
+                                      tmp_b.len,
+                                      &status);
+        icu_uscratch_free(&tmp_a);
+        icu_uscratch_free(&tmp_b);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
 
     return INT2NUM(result);
 }
 
-VALUE spoof_checker_get_skeleton(VALUE self, VALUE str)
+const struct USpoofChecker* icu_spoof_checker_service(VALUE checker)
 {
-    StringValue(str);
-    GET_SPOOF_CHECKER(this);
+    icu_spoof_checker_data* this;
+    TypedData_Get_Struct(checker, icu_spoof_checker_data, &icu_spoof_checker_type, this);
+    return this->service;
+}
 
-    VALUE in = icu_ustring_from_rb_str(str);
-    VALUE out = icu_ustring_init_with_capa_enc(icu_ustring_capa(in), ICU_RUBY_ENCODING_INDEX);
+// writes the skeleton of in to out, which grows to fit it, and returns its length
+int32_t icu_spoof_skeleton(const USpoofChecker* service, const icu_uscratch* in, icu_uscratch* out)
+{
     int retried = FALSE;
     int32_t len_bytes;
     UErrorCode status = U_ZERO_ERROR;
     do {
-        // UTF-8 version does the conversion internally so we relies on UChar version here!
-        len_bytes = uspoof_getSkeleton(this->service, 0 /* deprecated */,
-                                       icu_ustring_ptr(in), icu_ustring_len(in),
-                                       icu_ustring_ptr(out), icu_ustring_capa(out),
+        len_bytes = uspoof_getSkeleton(service, 0 /* deprecated */,
+                                       in->ptr, in->len,
+                                       out->ptr, out->capa,
                                        &status);
         if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
             retried = TRUE;
-            icu_ustring_resize(out, len_bytes + RUBY_C_STRING_TERMINATOR_SIZE);
+            icu_count_retry(ICU_RETRY_SKELETON);
+            icu_uscratch_resize(out, len_bytes + RUBY_C_STRING_TERMINATOR_SIZE);
             status = U_ZERO_ERROR;
         } else if (U_FAILURE(status)) {
             icu_rb_raise_icu_error(status);
@@ -144,39 +217,361 @@ VALUE spoof_checker_get_skeleton(VALUE self, VALUE str)
             break;
         }
     } while (retried);
+    return len_bytes;
+}
+
+// writes the skeleton of a UTF-8 string straight into the result
+static VALUE spoof_checker_get_skeleton_utf8(const icu_spoof_checker_data* this, VALUE str, int enc_idx)
+{
+    // skeletons are mostly about as long as the input, the buffer grows when they aren't
+    VALUE result = rb_str_buf_new(RSTRING_LEN(str) + 16);
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = uspoof_getSkeletonUTF8(this->service, 0 /* deprecated */,
+                                         RSTRING_PTR(str), RSTRING_LENINT(str),
+                                         RSTRING_PTR(result), (int32_t)rb_str_capacity(result),
+                                         &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        icu_count_retry(ICU_RETRY_SKELETON);
+        rb_str_modify_expand(result, len);
+        status = U_ZERO_ERROR;
+        len = uspoof_getSkeletonUTF8(this->service, 0 /* deprecated */,
+                                     RSTRING_PTR(str), RSTRING_LENINT(str),
+                                     RSTRING_PTR(result), (int32_t)rb_str_capacity(result),
+                                     &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    rb_str_set_len(result, len);
+    rb_enc_associate_index(result, enc_idx);
+    return result;
+}
+
+VALUE spoof_checker_get_skeleton(VALUE self, VALUE str)
+{
+    StringValue(str);
+    str = spoof_checker_ractor_str(str);
+    GET_SPOOF_CHECKER(this);
+
+    int enc_idx = ICU_RUBY_ENCODING_INDEX;
+    if (enc_idx == rb_utf8_encindex() && icu_is_rb_str_as_utf_8(str)) {
+        return spoof_checker_get_skeleton_utf8(this, str, enc_idx);
+    }
 
-    return icu_ustring_to_rb_enc_str_with_len(out, len_bytes);
+    icu_uscratch in;
+    icu_uscratch out;
+    icu_uscratch_from_rb_str(&in, str);
+    // skeletons are rarely more than twice as long as the input
+    icu_uscratch_init(&out, in.len * 2 + 16);
+    int32_t len_bytes = icu_spoof_skeleton(this->service, &in, &out);
+    icu_uscratch_free(&in);
+
+    VALUE result = icu_uchar_to_rb_enc_str(out.ptr, len_bytes, enc_idx);
+    icu_uscratch_free(&out);
+    return result;
+}
+
+// result may be NULL when only the returned checks are needed
+static int32_t spoof_checker_check_internal(const icu_spoof_checker_data* this, VALUE rb_str,
+                                            USpoofCheckResult* result)
+{
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t checks = 0;
+    if (icu_is_rb_str_as_utf_8(rb_str)) {
+        checks = uspoof_check2UTF8(this->service,
+                                   RSTRING_PTR(rb_str),
+                                   RSTRING_LENINT(rb_str),
+                                   result,
+                                   &status);
+    } else {
+        icu_uscratch in;
+        icu_uscratch_from_rb_str(&in, rb_str);
+        checks = uspoof_check2(this->service,
+                               in.ptr,
+                               in.len,
+                               result,
+                               &status);
+        icu_uscratch_free(&in);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return checks;
 }
 
 VALUE spoof_checker_check(VALUE self, VALUE rb_str)
 {
     StringValue(rb_str);
+    rb_str = spoof_checker_ractor_str(rb_str);
     GET_SPOOF_CHECKER(this);
 
+    return INT2NUM(spoof_checker_check_internal(this, rb_str, NULL));
+}
+
+/* Checks every String of ary, returns their check results in an Array. */
+VALUE spoof_checker_check_all(VALUE self, VALUE ary)
+{
+    Check_Type(ary, T_ARRAY);
+    GET_SPOOF_CHECKER(this);
+
+    VALUE result = rb_ary_new2(RARRAY_LEN(ary));
+    for (long i = 0; i < RARRAY_LEN(ary); ++i) {
+        VALUE rb_str = rb_ary_entry(ary, i);
+        StringValue(rb_str);
+        rb_str = spoof_checker_ractor_str(rb_str);
+        rb_ary_push(result, INT2NUM(spoof_checker_check_internal(this, rb_str, NULL)));
+    }
+    return result;
+}
+
+// the zero digits of the numbering systems in set
+static VALUE spoof_checker_numerics_to_rb_ary(const USet* set)
+{
+    VALUE result = rb_ary_new();
+    rb_encoding* enc = rb_utf8_encoding();
+    int32_t count = uset_getItemCount(set);
+    for (int32_t i = 0; i < count; ++i) {
+        UChar32 start;
+        UChar32 end;
+        UErrorCode status = U_ZERO_ERROR;
+        if (uset_getItem(set, i, &start, &end, NULL, 0, &status) != 0) {
+            continue; // a string, numerics only holds code points
+        }
+        for (UChar32 c = start; c <= end; ++c) {
+            rb_ary_push(result, rb_enc_uint_chr(c, enc));
+        }
+    }
+    return result;
+}
+
+typedef struct {
+    const icu_spoof_checker_data* this;
+    VALUE rb_str;
+    USpoofCheckResult* result;
+} spoof_checker_details_args;
+
+static VALUE spoof_checker_check_details_internal(VALUE _args)
+{
+    spoof_checker_details_args* args = (spoof_checker_details_args*)_args;
+    int32_t checks = spoof_checker_check_internal(args->this, args->rb_str, args->result);
     UErrorCode status = U_ZERO_ERROR;
-    int32_t result = 0;
+    int32_t enabled = uspoof_getChecks(args->this->service, &status);
+    VALUE restriction_level = Qnil;
+    VALUE numerics = Qnil;
+    if (enabled & USPOOF_RESTRICTION_LEVEL) {
+        restriction_level = INT2NUM(uspoof_getCheckResultRestrictionLevel(args->result, &status));
+    }
+    if (enabled & USPOOF_MIXED_NUMBERS) {
+        const USet* set = uspoof_getCheckResultNumerics(args->result, &status);
+        if (U_SUCCESS(status)) {
+            numerics = spoof_checker_numerics_to_rb_ary(set);
+        }
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return rb_struct_new(rb_cICU_SpoofChecker_CheckResult, INT2NUM(checks), restriction_level, numerics);
+}
 
-    // TODO: Migrate to uspoof_check2UTF8 once it's not draft
-    if (icu_is_rb_str_as_utf_8(rb_str)) {
-       result = uspoof_checkUTF8(this->service,
-                                 RSTRING_PTR(rb_str),
-                                 RSTRING_LENINT(rb_str),
-                                 NULL,
-                                 &status);
-    } else {
-        VALUE in = icu_ustring_from_rb_str(rb_str);
-        // TODO: Migrate to uspoof_check once it's not draft
-        result = uspoof_check(this->service,
-                              icu_ustring_ptr(in),
-                              icu_ustring_len(in),
-                              NULL,
-                              &status);
+static VALUE spoof_checker_close_check_result(VALUE _args)
+{
+    spoof_checker_details_args* args = (spoof_checker_details_args*)_args;
+    uspoof_closeCheckResult(args->result);
+    return Qnil;
+}
+
+/* Checks str like check and returns a CheckResult with the checks, the restriction level
+   the string meets and the zero digits of the numbering systems found in it. The level and
+   the numerics are nil unless the restriction_level and mixed_numbers checks are enabled. */
+VALUE spoof_checker_check_details(VALUE self, VALUE rb_str)
+{
+    StringValue(rb_str);
+    rb_str = spoof_checker_ractor_str(rb_str);
+    GET_SPOOF_CHECKER(this);
+
+    spoof_checker_details_args args;
+    args.this = this;
+    args.rb_str = rb_str;
+    UErrorCode status = U_ZERO_ERROR;
+    // Ractors sharing a frozen checker can't share its result
+    if (!spoof_checker_in_main_ractor()) {
+        args.result = uspoof_openCheckResult(&status);
+        if (U_FAILURE(status)) {
+            icu_rb_raise_icu_error(status);
+        }
+        return rb_ensure(spoof_checker_check_details_internal, (VALUE)&args,
+                         spoof_checker_close_check_result, (VALUE)&args);
     }
+    if (this->check_result == NULL) {
+        this->check_result = uspoof_openCheckResult(&status);
+        if (U_FAILURE(status)) {
+            this->check_result = NULL;
+            icu_rb_raise_icu_error(status);
+        }
+    }
+    args.result = this->check_result;
+    return spoof_checker_check_details_internal((VALUE)&args);
+}
+
+VALUE spoof_checker_get_allowed_locales(VALUE self)
+{
+    GET_SPOOF_CHECKER(this);
+
+    UErrorCode status = U_ZERO_ERROR;
+    const char* locales = uspoof_getAllowedLocales(this->service, &status);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
+    return rb_str_new_cstr(locales);
+}
 
-    return INT2NUM(result);
+/* Limits the characters to the scripts of locales, a comma separated String or an Array. */
+VALUE spoof_checker_set_allowed_locales(VALUE self, VALUE locales)
+{
+    rb_check_frozen(self);
+    GET_SPOOF_CHECKER(this);
+
+    if (RB_TYPE_P(locales, T_ARRAY)) {
+        locales = rb_ary_join(locales, rb_str_new_cstr(","));
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    uspoof_setAllowedLocales(this->service, StringValueCStr(locales), &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return spoof_checker_get_allowed_locales(self);
+}
+
+// limits the characters to the ones of chars
+static void spoof_checker_set_allowed_chars(const icu_spoof_checker_data* this, VALUE chars)
+{
+    icu_uscratch in;
+    icu_uscratch_from_rb_str(&in, chars);
+    USet* set = uset_openEmpty();
+    uset_addAllCodePoints(set, in.ptr, in.len);
+    icu_uscratch_free(&in);
+    UErrorCode status = U_ZERO_ERROR;
+    uspoof_setAllowedChars(this->service, set, &status);
+    uset_close(set);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+}
+
+static VALUE spoof_checker_make_shareable(VALUE checker)
+{
+    rb_obj_freeze(checker);
+#ifdef HAVE_RUBY_RACTOR_H
+    rb_ractor_make_shareable(checker);
+#endif
+    return checker;
+}
+
+// a copy the caller can't change afterwards, so the options can be compared later
+static VALUE spoof_checker_option_copy(VALUE value)
+{
+    if (value == Qundef) {
+        return Qnil;
+    }
+    if (RB_TYPE_P(value, T_STRING)) {
+        return rb_str_new_frozen(value);
+    }
+    if (RB_TYPE_P(value, T_ARRAY)) {
+        return rb_obj_freeze(rb_ary_dup(value));
+    }
+    return value;
+}
+
+/* Builds the profile unless it's already defined with the same options, which
+   lets call sites pass the options every time without paying for uspoof_open. */
+static VALUE spoof_checker_define_profile(VALUE name, VALUE opts)
+{
+    ID keywords[4] = {ID_checks, ID_level, ID_allowed_locales, ID_allowed_chars};
+    VALUE values[4];
+    rb_get_kwargs(opts, keywords, 0, 4, values);
+
+    VALUE options = rb_ary_new_capa(4);
+    for (int i = 0; i < 4; ++i) {
+        rb_ary_push(options, spoof_checker_option_copy(values[i]));
+    }
+    rb_obj_freeze(options);
+    VALUE defined = rb_hash_lookup(spoof_checker_profile_options, name);
+    if (!NIL_P(defined) && rb_equal(defined, options)) {
+        return rb_hash_lookup(spoof_checker_profiles, name);
+    }
+
+    VALUE checker = rb_class_new_instance(0, NULL, rb_cICU_SpoofChecker);
+    icu_spoof_checker_data* this;
+    TypedData_Get_Struct(checker, icu_spoof_checker_data, &icu_spoof_checker_type, this);
+    if (values[0] != Qundef && !NIL_P(values[0])) {
+        spoof_checker_set_checks(checker, values[0]);
+    }
+    if (values[1] != Qundef && !NIL_P(values[1])) {
+        spoof_checker_set_restriction_level(checker, values[1]);
+    }
+    // allowed locales also enable the char_limit check
+    if (values[2] != Qundef && !NIL_P(values[2])) {
+        spoof_checker_set_allowed_locales(checker, values[2]);
+    }
+    if (values[3] != Qundef && !NIL_P(values[3])) {
+        StringValue(values[3]);
+        spoof_checker_set_allowed_chars(this, values[3]);
+    }
+    spoof_checker_make_shareable(checker);
+    rb_hash_aset(spoof_checker_profiles, name, checker);
+    rb_hash_aset(spoof_checker_profile_options, name, options);
+    return checker;
+}
+
+static VALUE spoof_checker_clone_profile(VALUE profile)
+{
+    const icu_spoof_checker_data* prototype;
+    TypedData_Get_Struct(profile, icu_spoof_checker_data, &icu_spoof_checker_type, prototype);
+
+    VALUE checker = spoof_checker_alloc(rb_cICU_SpoofChecker);
+    icu_spoof_checker_data* this;
+    TypedData_Get_Struct(checker, icu_spoof_checker_data, &icu_spoof_checker_type, this);
+    this->rb_instance = checker;
+    this->check_result = NULL;
+    UErrorCode status = U_ZERO_ERROR;
+    this->service = uspoof_clone(prototype->service, &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return spoof_checker_make_shareable(checker);
+}
+
+/* Returns the frozen checker of the profile name which belongs to the current thread.
+   With checks:, level:, allowed_locales: or allowed_chars: the profile is (re)defined first,
+   unless it already has those options.
+   Checkers are cloned from the profile on the first use in a thread, they are frozen
+   and can be shared with other Ractors. */
+VALUE spoof_checker_singleton_profile(int argc, VALUE* argv, VALUE klass)
+{
+    VALUE name;
+    VALUE opts;
+    rb_scan_args(argc, argv, "1:", &name, &opts);
+
+    VALUE profile = NIL_P(opts) ? rb_hash_lookup(spoof_checker_profiles, name)
+                                : spoof_checker_define_profile(name, opts);
+    if (NIL_P(profile)) {
+        rb_raise(rb_eArgError, "undefined spoof checker profile %+"PRIsVALUE, name);
+    }
+
+    VALUE thread = rb_thread_current();
+    VALUE checkers = rb_thread_local_aref(thread, ID_thread_spoof_checkers);
+    if (NIL_P(checkers)) {
+        checkers = rb_hash_new();
+        rb_thread_local_aset(thread, ID_thread_spoof_checkers, checkers);
+    }
+    // [profile, clone] by name, a redefined profile replaces the clone of the old one
+    VALUE entry = rb_hash_lookup(checkers, name);
+    if (!NIL_P(entry) && RARRAY_AREF(entry, 0) == profile) {
+        return RARRAY_AREF(entry, 1);
+    }
+    VALUE checker = spoof_checker_clone_profile(profile);
+    rb_hash_aset(checkers, name, rb_assoc_new(profile, checker));
+    return checker;
 }
 
 static const char* k_checks_name = "@checks";
@@ -225,18 +620,51 @@ VALUE spoof_checker_available_restriction_levels(VALUE klass)
 
 void init_icu_spoof_checker(void)
 {
+    ID_thread_spoof_checkers = rb_intern("__icu_spoof_checkers__");
+    ID_checks = rb_intern("checks");
+    ID_level = rb_intern("level");
+    ID_allowed_locales = rb_intern("allowed_locales");
+    ID_allowed_chars = rb_intern("allowed_chars");
+    spoof_checker_profiles = rb_hash_new();
+    rb_gc_register_address(&spoof_checker_profiles);
+    spoof_checker_profile_options = rb_hash_new();
+    rb_gc_register_address(&spoof_checker_profile_options);
+#ifdef HAVE_RUBY_RACTOR_H
+    spoof_checker_main_ractor_key = rb_ractor_local_storage_ptr_newkey(NULL);
+    rb_ractor_local_storage_ptr_set(spoof_checker_main_ractor_key, &spoof_checker_profiles);
+#endif
+
     rb_cICU_SpoofChecker = rb_define_class_under(rb_mICU, "SpoofChecker", rb_cObject);
     rb_define_singleton_method(rb_cICU_SpoofChecker, "available_checks", spoof_checker_available_checks, 0);
     rb_define_singleton_method(rb_cICU_SpoofChecker, "available_restriction_levels", spoof_checker_available_restriction_levels, 0);
+    rb_define_singleton_method(rb_cICU_SpoofChecker, "profile", spoof_checker_singleton_profile, -1);
     rb_define_alloc_func(rb_cICU_SpoofChecker, spoof_checker_alloc);
+    // only the instance methods run in other Ractors, the class methods keep state of the main one
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+    rb_ext_ractor_safe(true);
+#endif
     rb_define_method(rb_cICU_SpoofChecker, "initialize", spoof_checker_initialize, 0);
     rb_define_method(rb_cICU_SpoofChecker, "restriction_level", spoof_checker_get_restriction_level, 0);
     rb_define_method(rb_cICU_SpoofChecker, "restriction_level=", spoof_checker_set_restriction_level, 1);
+    rb_define_method(rb_cICU_SpoofChecker, "allowed_locales", spoof_checker_get_allowed_locales, 0);
+    rb_define_method(rb_cICU_SpoofChecker, "allowed_locales=", spoof_checker_set_allowed_locales, 1);
     rb_define_method(rb_cICU_SpoofChecker, "check", spoof_checker_check, 1);
+    rb_define_method(rb_cICU_SpoofChecker, "check_all", spoof_checker_check_all, 1);
+    rb_define_method(rb_cICU_SpoofChecker, "check_details", spoof_checker_check_details, 1);
     rb_define_method(rb_cICU_SpoofChecker, "checks", spoof_checker_get_checks, 0);
     rb_define_method(rb_cICU_SpoofChecker, "checks=", spoof_checker_set_checks, 1);
     rb_define_method(rb_cICU_SpoofChecker, "confusable?", spoof_checker_confusable, 2);
     rb_define_method(rb_cICU_SpoofChecker, "get_skeleton", spoof_checker_get_skeleton, 1);
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+    rb_ext_ractor_safe(false);
+#endif
+
+    rb_cICU_SpoofChecker_CheckResult = rb_struct_define_under(rb_cICU_SpoofChecker,
+                                                              "CheckResult",
+                                                              "checks",
+                                                              "restriction_level",
+                                                              "numerics",
+                                                              NULL);
 }
 
 #undef DEFINE_SPOOF_ENUM_CONST
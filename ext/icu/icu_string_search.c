@@ -0,0 +1,210 @@
+#include "icu.h"
+#include "unicode/usearch.h"
+
+#define GET_STRING_SEARCH(_data) icu_string_search_data* _data; \
+                                 TypedData_Get_Struct(self, icu_string_search_data, &icu_string_search_type, _data)
+
+VALUE rb_cICU_StringSearch;
+
+// usearch_openFromCollator doesn't take an empty text, the search starts with this one
+static const UChar k_placeholder_text[] = {0x20};
+
+typedef struct {
+    UStringSearch* service;
+    VALUE collator; // the service uses its UCollator
+    VALUE pattern;
+    UChar* text; // the text being searched, the service points to it
+    int32_t text_len;
+    int32_t text_capa;
+    VALUE lock; // the service holds the text, searches can't run concurrently
+} icu_string_search_data;
+
+static void string_search_mark(void* _this)
+{
+    icu_string_search_data* this = _this;
+    rb_gc_mark(this->collator);
+    rb_gc_mark(this->pattern);
+    rb_gc_mark(this->lock);
+}
+
+static void string_search_free(void* _this)
+{
+    icu_string_search_data* this = _this;
+    if (this->service != NULL) {
+        usearch_close(this->service);
+    }
+    if (this->text != NULL) {
+        ruby_xfree(this->text);
+    }
+}
+
+static size_t string_search_memsize(const void* _this)
+{
+    const icu_string_search_data* this = _this;
+    return sizeof(icu_string_search_data) + sizeof(UChar) * this->text_capa;
+}
+
+static const rb_data_type_t icu_string_search_type = {
+    "icu/string_search",
+    {string_search_mark, string_search_free, string_search_memsize,},
+    0, 0,
+    RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+VALUE string_search_alloc(VALUE self)
+{
+    icu_string_search_data* this;
+    return TypedData_Make_Struct(self, icu_string_search_data, &icu_string_search_type, this);
+}
+
+/* Compiles pattern once for searches with the collator, a Collator or a locale name.
+   The collator strength decides what matches, :primary ignores accents and case. */
+VALUE string_search_initialize(VALUE self, VALUE pattern, VALUE collator)
+{
+    StringValue(pattern);
+    if (!rb_obj_is_kind_of(collator, rb_cICU_Collator)) {
+        collator = rb_class_new_instance(1, &collator, rb_cICU_Collator);
+    }
+    GET_STRING_SEARCH(this);
+    this->service = NULL;
+    this->collator = collator;
+    this->pattern = rb_str_new_frozen(pattern);
+    this->text = NULL;
+    this->text_len = 0;
+    this->text_capa = 0;
+    this->lock = rb_mutex_new();
+
+    VALUE u_pattern = icu_ustring_from_rb_str(pattern);
+    if (icu_ustring_len(u_pattern) == 0) {
+        icu_rb_raise_icu_invalid_parameter("pattern", "can't be empty");
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    this->service = usearch_openFromCollator(icu_ustring_ptr(u_pattern), icu_ustring_len(u_pattern),
+                                             k_placeholder_text, 1,
+                                             icu_collator_service(collator), NULL,
+                                             &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    RB_GC_GUARD(u_pattern);
+
+    return self;
+}
+
+static void string_search_reserve_text(icu_string_search_data* this, int32_t capa)
+{
+    if (capa > this->text_capa) {
+        REALLOC_N(this->text, UChar, capa);
+        this->text_capa = capa;
+    }
+}
+
+// converts str into the text buffer, which only grows so searches over many texts reuse it
+static void string_search_set_text(icu_string_search_data* this, VALUE str)
+{
+    // enough for UTF-8, other charsets may need more units than bytes
+    string_search_reserve_text(this, RSTRING_LENINT(str) + RUBY_C_STRING_TERMINATOR_SIZE);
+    UErrorCode status = U_ZERO_ERROR;
+    this->text_len = icu_rb_str_to_uchar(str, this->text, this->text_capa, &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        icu_count_retry(ICU_RETRY_USTRING_FROM_RB_STR);
+        string_search_reserve_text(this, this->text_len + RUBY_C_STRING_TERMINATOR_SIZE);
+        status = U_ZERO_ERROR;
+        this->text_len = icu_rb_str_to_uchar(str, this->text, this->text_capa, &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    if (this->text_len > 0) {
+        usearch_setText(this->service, this->text, this->text_len, &status);
+    } else { // usearch_setText doesn't take an empty text either
+        usearch_setText(this->service, k_placeholder_text, 1, &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+}
+
+typedef struct {
+    icu_string_search_data* this;
+    VALUE str;
+} string_search_each_args;
+
+// returns the character offsets and lengths of the matches one after another
+static VALUE string_search_matches_locked(VALUE _args)
+{
+    string_search_each_args* args = (string_search_each_args*)_args;
+    icu_string_search_data* this = args->this;
+    VALUE matches = rb_ary_new();
+    string_search_set_text(this, args->str);
+    if (this->text_len == 0) {
+        return matches;
+    }
+
+    // the attributes of the collator may have changed since the last search
+    usearch_reset(this->service);
+    int32_t unit_offset = 0;
+    long char_offset = 0;
+    for (;;) {
+        UErrorCode status = U_ZERO_ERROR;
+        int32_t start = usearch_next(this->service, &status);
+        if (U_FAILURE(status)) {
+            icu_rb_raise_icu_error(status);
+        }
+        if (start == USEARCH_DONE) {
+            break;
+        }
+        int32_t len = usearch_getMatchedLength(this->service);
+        // matches come in order, the character offset is counted from the previous one
+        char_offset += u_countChar32(this->text + unit_offset, start - unit_offset);
+        unit_offset = start;
+        rb_ary_push(matches, LONG2NUM(char_offset));
+        rb_ary_push(matches, INT2NUM(u_countChar32(this->text + start, len)));
+    }
+    return matches;
+}
+
+/* Yields the character offset and length of every match of the pattern in str,
+   so str[offset, length] is the matched text. The matches are found before the
+   first yield, so the block may search again with the same object. */
+VALUE string_search_each_match(VALUE self, VALUE str)
+{
+    RETURN_ENUMERATOR(self, 1, &str);
+    StringValue(str);
+    GET_STRING_SEARCH(this);
+
+    string_search_each_args args;
+    args.this = this;
+    args.str = str;
+    VALUE matches = rb_mutex_synchronize(this->lock, string_search_matches_locked, (VALUE)&args);
+    for (long i = 0; i + 1 < RARRAY_LEN(matches); i += 2) {
+        rb_yield_values(2, RARRAY_AREF(matches, i), RARRAY_AREF(matches, i + 1));
+    }
+    return self;
+}
+
+VALUE string_search_pattern(VALUE self)
+{
+    GET_STRING_SEARCH(this);
+    return this->pattern;
+}
+
+VALUE string_search_collator(VALUE self)
+{
+    GET_STRING_SEARCH(this);
+    return this->collator;
+}
+
+void init_icu_string_search(void)
+{
+    rb_cICU_StringSearch = rb_define_class_under(rb_mICU, "StringSearch", rb_cObject);
+    rb_define_alloc_func(rb_cICU_StringSearch, string_search_alloc);
+    rb_define_method(rb_cICU_StringSearch, "initialize", string_search_initialize, 2);
+    rb_define_method(rb_cICU_StringSearch, "each_match", string_search_each_match, 1);
+    rb_define_method(rb_cICU_StringSearch, "pattern", string_search_pattern, 0);
+    rb_define_method(rb_cICU_StringSearch, "collator", string_search_collator, 0);
+}
+
+#undef GET_STRING_SEARCH
+
+/* vim: set expandtab sws=4 sw=4: */
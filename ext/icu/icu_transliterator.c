@@ -1,5 +1,7 @@
 #include "icu.h"
 #include "unicode/utrans.h"
+#include "unicode/ucnv.h"
+#include <string.h>
 
 #define GET_TRANSLITERATOR(_data) icu_transliterator_data* _data; \
                                   TypedData_Get_Struct(self, icu_transliterator_data, &icu_transliterator_type, _data)
@@ -37,6 +39,85 @@ VALUE transliterator_alloc(VALUE self)
     return TypedData_Make_Struct(self, icu_transliterator_data, &icu_transliterator_type, this);
 }
 
+#define TRANSLITERATOR_CACHE_DEFAULT_SIZE 32
+
+/* Compiled transliterators keyed by direction, id and rules. utrans_openU
+   parses and compiles the rules, a clone of a cached prototype skips that.
+   The cache is process wide and unlocked: it is only touched with the GVL held, and
+   Transliterator methods aren't marked Ractor safe, so only the main Ractor reaches it.
+   Lookups and evictions scan the entries linearly, which is meant for a capacity of
+   tens of entries, not thousands. */
+typedef struct {
+    UChar* key;
+    int32_t key_len;
+    UTransliterator* prototype;
+    unsigned long last_used;
+} transliterator_cache_entry;
+
+static transliterator_cache_entry* cache_entries = NULL;
+static long cache_len = 0;
+static long cache_capa = TRANSLITERATOR_CACHE_DEFAULT_SIZE;
+static unsigned long cache_clock = 0;
+static size_t cache_hits = 0;
+static size_t cache_misses = 0;
+
+static void transliterator_cache_evict(long index)
+{
+    utrans_close(cache_entries[index].prototype);
+    xfree(cache_entries[index].key);
+    cache_entries[index] = cache_entries[--cache_len];
+}
+
+static long transliterator_cache_least_recently_used(void)
+{
+    long lru = 0;
+    for (long i = 1; i < cache_len; ++i) {
+        if (cache_entries[i].last_used < cache_entries[lru].last_used) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+// returns a clone of the cached prototype or NULL on a miss
+static UTransliterator* transliterator_cache_clone(const UChar* key, int32_t key_len, UErrorCode* status)
+{
+    for (long i = 0; i < cache_len; ++i) {
+        transliterator_cache_entry* entry = &cache_entries[i];
+        if (entry->key_len == key_len && u_memcmp(entry->key, key, key_len) == 0) {
+            cache_hits++;
+            entry->last_used = ++cache_clock;
+            return utrans_clone(entry->prototype, status);
+        }
+    }
+    cache_misses++;
+    return NULL;
+}
+
+static void transliterator_cache_store(const UChar* key, int32_t key_len, const UTransliterator* service)
+{
+    if (cache_capa <= 0) {
+        return;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    UTransliterator* prototype = utrans_clone(service, &status);
+    if (U_FAILURE(status)) { // the cache is only an optimization
+        return;
+    }
+    if (cache_entries == NULL) {
+        cache_entries = ALLOC_N(transliterator_cache_entry, cache_capa);
+    }
+    if (cache_len == cache_capa) {
+        transliterator_cache_evict(transliterator_cache_least_recently_used());
+    }
+    transliterator_cache_entry* entry = &cache_entries[cache_len++];
+    entry->key = ALLOC_N(UChar, key_len);
+    u_memcpy(entry->key, key, key_len);
+    entry->key_len = key_len;
+    entry->prototype = prototype;
+    entry->last_used = ++cache_clock;
+}
+
 VALUE transliterator_initialize(int argc, VALUE* argv, VALUE self)
 {
     GET_TRANSLITERATOR(this);
@@ -62,19 +143,40 @@ VALUE transliterator_initialize(int argc, VALUE* argv, VALUE self)
     if (SYM2ID(direction) == ID_forward) {
         u_direction = UTRANS_FORWARD;
     }
-    VALUE u_rules;
+    VALUE u_rules = Qnil;
     if (!NIL_P(rules)) {
         u_rules = icu_ustring_from_rb_str(rules);
     }
-    UParseError parser_error;
+
+    // direction, id, separator, rules: the separator tells nil rules from empty ones
+    int32_t id_len = icu_ustring_len(u_id);
+    int32_t rules_len = NIL_P(rules) ? 0 : icu_ustring_len(u_rules);
+    icu_uscratch key;
+    icu_uscratch_init(&key, 2 + id_len + rules_len);
+    key.ptr[0] = (UChar)u_direction;
+    u_memcpy(key.ptr + 1, icu_ustring_ptr(u_id), id_len);
+    key.ptr[1 + id_len] = NIL_P(rules) ? 0 : 1;
+    if (!NIL_P(rules)) {
+        u_memcpy(key.ptr + 2 + id_len, icu_ustring_ptr(u_rules), rules_len);
+    }
+    key.len = 2 + id_len + rules_len;
+
     UErrorCode status = U_ZERO_ERROR;
-    this->service = utrans_openU(icu_ustring_ptr(u_id),
-                                        icu_ustring_len(u_id),
-                                        u_direction,
-                                        NIL_P(rules) ? NULL : icu_ustring_ptr(u_rules),
-                                        NIL_P(rules) ? 0 : icu_ustring_len(u_rules),
-                                        &parser_error, // TODO: should be possible to interpolate
-                                        &status);
+    this->service = transliterator_cache_clone(key.ptr, key.len, &status);
+    if (this->service == NULL && U_SUCCESS(status)) {
+        UParseError parser_error;
+        this->service = utrans_openU(icu_ustring_ptr(u_id),
+                                            icu_ustring_len(u_id),
+                                            u_direction,
+                                            NIL_P(rules) ? NULL : icu_ustring_ptr(u_rules),
+                                            NIL_P(rules) ? 0 : icu_ustring_len(u_rules),
+                                            &parser_error, // TODO: should be possible to interpolate
+                                            &status);
+        if (U_SUCCESS(status) && this->service != NULL) {
+            transliterator_cache_store(key.ptr, key.len, this->service);
+        }
+    }
+    icu_uscratch_free(&key);
     if (U_FAILURE(status)) {
         icu_rb_raise_icu_error(status);
     }
@@ -85,40 +187,381 @@ VALUE transliterator_initialize(int argc, VALUE* argv, VALUE self)
     return self;
 }
 
+/* Returns the hits and misses of the compiled transliterator cache, its size and capacity. */
+VALUE transliterator_cache_stats(VALUE self)
+{
+    VALUE result = rb_hash_new();
+    rb_hash_aset(result, ID2SYM(rb_intern("hits")), SIZET2NUM(cache_hits));
+    rb_hash_aset(result, ID2SYM(rb_intern("misses")), SIZET2NUM(cache_misses));
+    rb_hash_aset(result, ID2SYM(rb_intern("size")), LONG2NUM(cache_len));
+    rb_hash_aset(result, ID2SYM(rb_intern("capacity")), LONG2NUM(cache_capa));
+    return result;
+}
+
+/* Drops the cached transliterators and resets the stats. */
+VALUE transliterator_clear_cache(VALUE self)
+{
+    while (cache_len > 0) {
+        transliterator_cache_evict(cache_len - 1);
+    }
+    cache_hits = cache_misses = 0;
+    return Qnil;
+}
+
+/* Sets how many compiled transliterators are kept, 0 disables the cache. Lookups scan
+   the entries linearly, so keep it small. */
+VALUE transliterator_set_cache_size(VALUE self, VALUE size)
+{
+    long capa = NUM2LONG(size);
+    if (capa < 0) {
+        rb_raise(rb_eArgError, "cache size can't be negative");
+    }
+    while (cache_len > capa) {
+        transliterator_cache_evict(transliterator_cache_least_recently_used());
+    }
+    if (cache_entries != NULL) {
+        REALLOC_N(cache_entries, transliterator_cache_entry, capa > 0 ? capa : 1);
+    }
+    cache_capa = capa;
+    return size;
+}
+
+/* The text being transliterated. It's a malloc'ed buffer which grows as
+   the transliterator replaces text, so it never overflows. The callbacks
+   run without the GVL: a failed allocation is only recorded. */
+typedef struct {
+    UChar* ptr;
+    int32_t len;
+    int32_t capa;
+    int no_memory;
+} transliterator_text;
+
+static int transliterator_text_reserve(transliterator_text* text, int32_t len)
+{
+    if (len <= text->capa) {
+        return TRUE;
+    }
+    int32_t capa = text->capa * 2 > len ? text->capa * 2 : len;
+    UChar* ptr = realloc(text->ptr, sizeof(UChar) * capa);
+    if (ptr == NULL) {
+        text->no_memory = TRUE;
+        return FALSE;
+    }
+    text->ptr = ptr;
+    text->capa = capa;
+    return TRUE;
+}
+
+static int32_t transliterator_text_length(const UReplaceable* rep)
+{
+    return ((const transliterator_text*)rep)->len;
+}
+
+static UChar transliterator_text_char_at(const UReplaceable* rep, int32_t offset)
+{
+    const transliterator_text* text = (const transliterator_text*)rep;
+    return offset >= 0 && offset < text->len ? text->ptr[offset] : 0xFFFF;
+}
+
+static UChar32 transliterator_text_char32_at(const UReplaceable* rep, int32_t offset)
+{
+    const transliterator_text* text = (const transliterator_text*)rep;
+    if (offset < 0 || offset >= text->len) {
+        return 0xFFFF;
+    }
+    UChar32 c;
+    U16_GET(text->ptr, 0, offset, text->len, c);
+    return c;
+}
+
+static void transliterator_text_replace(UReplaceable* rep, int32_t start, int32_t limit,
+                                        const UChar* replacement, int32_t replacement_len)
+{
+    transliterator_text* text = (transliterator_text*)rep;
+    if (replacement_len < 0) {
+        replacement_len = u_strlen(replacement);
+    }
+    UChar* copy = NULL;
+    if (replacement >= text->ptr && replacement < text->ptr + text->capa) {
+        // the replacement is a part of the text itself, it moves below
+        copy = malloc(sizeof(UChar) * (replacement_len + 1));
+        if (copy == NULL) {
+            text->no_memory = TRUE;
+            return;
+        }
+        u_memcpy(copy, replacement, replacement_len);
+        replacement = copy;
+    }
+    int32_t new_len = text->len - (limit - start) + replacement_len;
+    if (transliterator_text_reserve(text, new_len)) {
+        u_memmove(text->ptr + start + replacement_len, text->ptr + limit, text->len - limit);
+        u_memcpy(text->ptr + start, replacement, replacement_len);
+        text->len = new_len;
+    }
+    free(copy);
+}
+
+static void transliterator_text_extract(UReplaceable* rep, int32_t start, int32_t limit, UChar* dst)
+{
+    u_memcpy(dst, ((transliterator_text*)rep)->ptr + start, limit - start);
+}
+
+static void transliterator_text_copy(UReplaceable* rep, int32_t start, int32_t limit, int32_t dest)
+{
+    transliterator_text* text = (transliterator_text*)rep;
+    // inserts at dest, replace takes care of the overlap
+    transliterator_text_replace(rep, dest, dest, text->ptr + start, limit - start);
+}
+
+static UReplaceableCallbacks transliterator_text_callbacks = {
+    transliterator_text_length,
+    transliterator_text_char_at,
+    transliterator_text_char32_at,
+    transliterator_text_replace,
+    transliterator_text_extract,
+    transliterator_text_copy,
+};
+
+typedef struct {
+    const UTransliterator* service;
+    transliterator_text text;
+    int32_t limit;
+    UErrorCode status;
+} transliterator_transliterate_args;
+
+static void* transliterator_transliterate_nogvl(void* _args)
+{
+    transliterator_transliterate_args* args = _args;
+    utrans_trans(args->service,
+                 (UReplaceable*)&args->text, &transliterator_text_callbacks,
+                 0 /* always start from the beginning */, &args->limit,
+                 &args->status);
+    return NULL;
+}
+
+static VALUE transliterator_transliterate_run(VALUE _args)
+{
+    transliterator_transliterate_args* args = (transliterator_transliterate_args*)_args;
+    icu_call_without_gvl_when(args->text.len, transliterator_transliterate_nogvl, args);
+    if (args->text.no_memory) {
+        rb_memerror();
+    }
+    if (U_FAILURE(args->status)) {
+        icu_rb_raise_icu_error(args->status);
+    }
+    return icu_uchar_to_rb_enc_str(args->text.ptr, args->text.len, ICU_RUBY_ENCODING_INDEX);
+}
+
+static VALUE transliterator_transliterate_free(VALUE _args)
+{
+    free(((transliterator_transliterate_args*)_args)->text.ptr);
+    return Qnil;
+}
+
 VALUE transliterator_transliterate(VALUE self, VALUE str)
 {
     StringValue(str);
     GET_TRANSLITERATOR(this);
 
-    VALUE u_str = icu_ustring_from_rb_str(str);
-    UErrorCode status = U_ZERO_ERROR;
-    int32_t original_len = icu_ustring_len(u_str);
-    int32_t capa = icu_ustring_capa(u_str);
-    int32_t len;
-    int32_t limit;
-    int retried = FALSE;
+    transliterator_transliterate_args args;
+    args.service = this->service;
+    args.status = U_ZERO_ERROR;
+    args.text.no_memory = FALSE;
+    // enough for UTF-8, other charsets may need more units than bytes
+    args.text.capa = RSTRING_LENINT(str) + RUBY_C_STRING_TERMINATOR_SIZE;
+    args.text.ptr = malloc(sizeof(UChar) * args.text.capa);
+    if (args.text.ptr == NULL) {
+        rb_memerror();
+    }
+    args.text.len = icu_rb_str_to_uchar(str, args.text.ptr, args.text.capa, &args.status);
+    if (args.status == U_BUFFER_OVERFLOW_ERROR) {
+        icu_count_retry(ICU_RETRY_USTRING_FROM_RB_STR);
+        if (!transliterator_text_reserve(&args.text, args.text.len + RUBY_C_STRING_TERMINATOR_SIZE)) {
+            free(args.text.ptr);
+            rb_memerror();
+        }
+        args.status = U_ZERO_ERROR;
+        args.text.len = icu_rb_str_to_uchar(str, args.text.ptr, args.text.capa, &args.status);
+    }
+    if (U_FAILURE(args.status)) {
+        free(args.text.ptr);
+        icu_rb_raise_icu_error(args.status);
+    }
+    args.limit = args.text.len;
+
+    return rb_ensure(transliterator_transliterate_run, (VALUE)&args,
+                     transliterator_transliterate_free, (VALUE)&args);
+}
+
+// the transliterator gets the input by slices, replacements move the text after them around
+#define TRANSLITERATOR_STREAM_SLICE_SIZE 128
+
+typedef struct {
+    icu_stream stream;
+    const UTransliterator* service;
+    const char* converter_name;
+    UConverter* converter;
+    icu_uscratch input; // decoded text which isn't given to the transliterator yet
+    int32_t input_offset;
+    int finish;
+    transliterator_text text; // [0, pos.start) is done and only kept for context
+    UTransPosition pos;
+    transliterator_text out; // finished text to be written out
+    UErrorCode status;
+} transliterator_stream_state;
+
+static void transliterator_text_append(transliterator_text* text, const UChar* src, int32_t len)
+{
+    if (transliterator_text_reserve(text, text->len + len)) {
+        u_memcpy(text->ptr + text->len, src, len);
+        text->len += len;
+    }
+}
+
+// moves what's done to out and drops what the transliterator no longer looks back at
+static void transliterator_stream_move_done(transliterator_stream_state* state, int32_t done)
+{
+    transliterator_text_append(&state->out, state->text.ptr + done, state->pos.start - done);
+
+    // utrans_transIncremental moves contextStart to the start minus the longest context
+    // the rules look back at, nothing before it is looked at again
+    int32_t dropped = state->pos.contextStart;
+    if (dropped > 0) {
+        state->text.len -= dropped;
+        u_memmove(state->text.ptr, state->text.ptr + dropped, state->text.len);
+        state->pos.contextStart = 0;
+        state->pos.contextLimit -= dropped;
+        state->pos.start -= dropped;
+        state->pos.limit -= dropped;
+    }
+}
+
+static void* transliterator_stream_nogvl(void* _state)
+{
+    transliterator_stream_state* state = _state;
+    while (state->input_offset < state->input.len && U_SUCCESS(state->status) && !state->text.no_memory) {
+        int32_t len = state->input.len - state->input_offset;
+        if (len > TRANSLITERATOR_STREAM_SLICE_SIZE) {
+            len = TRANSLITERATOR_STREAM_SLICE_SIZE;
+        }
+        transliterator_text_append(&state->text, state->input.ptr + state->input_offset, len);
+        state->input_offset += len;
+        state->pos.contextLimit = state->pos.limit = state->text.len;
+
+        int32_t done = state->pos.start;
+        utrans_transIncremental(state->service,
+                                (UReplaceable*)&state->text, &transliterator_text_callbacks,
+                                &state->pos, &state->status);
+        transliterator_stream_move_done(state, done);
+    }
+    if (state->finish && U_SUCCESS(state->status)) {
+        // the pending tail waits for more input to be unambiguous, it's finished with what's there
+        int32_t done = state->pos.start;
+        utrans_trans(state->service,
+                     (UReplaceable*)&state->text, &transliterator_text_callbacks,
+                     state->pos.start, &state->pos.limit,
+                     &state->status);
+        state->pos.start = state->pos.limit;
+        transliterator_stream_move_done(state, done);
+    }
+    return NULL;
+}
+
+static void transliterator_stream_decode(transliterator_stream_state* state, VALUE chunk)
+{
+    const char* source = NIL_P(chunk) ? NULL : RSTRING_PTR(chunk);
+    const char* source_limit = NIL_P(chunk) ? NULL : RSTRING_END(chunk);
+    icu_uscratch* input = &state->input;
+    input->len = 0;
+    state->input_offset = 0;
+    // a unit never needs more than a byte, the converter may hold a few units back
+    int32_t needed = (int32_t)(source_limit - source) + 16;
+    if (needed > input->capa) {
+        icu_uscratch_resize(input, needed);
+    }
+    UErrorCode status;
     do {
-        len = limit = original_len;
-
-        utrans_transUChars(this->service,
-                           icu_ustring_ptr(u_str), &len, capa,
-                           0 /* always start from the beginning */, &limit,
-                           &status);
-
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            u_str = icu_ustring_from_rb_str(str);
-            capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
-            icu_ustring_resize(u_str, capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
+        UChar* target = input->ptr + input->len;
+        UChar* target_start = target;
+        status = U_ZERO_ERROR;
+        ucnv_toUnicode(state->converter,
+                       &target, input->ptr + input->capa,
+                       &source, source_limit,
+                       NULL, state->finish, &status);
+        input->len += (int32_t)(target - target_start);
+        if (status == U_BUFFER_OVERFLOW_ERROR) { // continues where it stopped
+            icu_uscratch_resize(input, input->capa * 2);
         }
-    } while (retried);
+    } while (status == U_BUFFER_OVERFLOW_ERROR);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+}
+
+static void transliterator_stream_process(icu_stream* stream, VALUE chunk)
+{
+    transliterator_stream_state* state = (transliterator_stream_state*)stream;
+    state->finish = NIL_P(chunk);
+    transliterator_stream_decode(state, chunk);
+    icu_call_without_gvl_when(state->input.len, transliterator_stream_nogvl, state);
+    if (state->text.no_memory || state->out.no_memory) {
+        rb_memerror();
+    }
+    if (U_FAILURE(state->status)) {
+        icu_rb_raise_icu_error(state->status);
+    }
+    if (state->out.len > 0) {
+        icu_stream_write(stream, icu_uchar_to_rb_enc_str(state->out.ptr, state->out.len, ICU_RUBY_ENCODING_INDEX));
+        state->out.len = 0;
+    }
+}
+
+static void transliterator_stream_close(icu_stream* stream)
+{
+    transliterator_stream_state* state = (transliterator_stream_state*)stream;
+    icu_converter_give_back(state->converter_name, state->converter);
+    icu_uscratch_free(&state->input);
+    free(state->text.ptr);
+    free(state->out.ptr);
+}
+
+static int transliterator_text_init(transliterator_text* text, int32_t capa)
+{
+    text->no_memory = FALSE;
+    text->len = 0;
+    text->capa = capa;
+    text->ptr = malloc(sizeof(UChar) * capa);
+    return text->ptr != NULL;
+}
+
+/* Reads io_in by chunks and writes the transliterated text to io_out, returns the bytes written.
+   The context the rules look back at is kept across chunks, so the memory stays bounded by
+   the chunk size plus the longest rule context. The input is decoded as the external encoding of io_in.
+   ICU only commits unambiguous text in this mode, which costs more per character than
+   transliterate, so text with natural boundaries such as lines is faster by pieces. */
+VALUE transliterator_transliterate_stream(int argc, VALUE* argv, VALUE self)
+{
+    GET_TRANSLITERATOR(this);
+    transliterator_stream_state state;
+    icu_stream_init(&state.stream, argc, argv);
+    state.stream.process = transliterator_stream_process;
+    state.stream.close = transliterator_stream_close;
+    state.service = this->service;
+    state.pos.contextStart = state.pos.contextLimit = state.pos.start = state.pos.limit = 0;
+    state.status = U_ZERO_ERROR;
+
+    state.converter_name = icu_converter_name_for_enc_idx(icu_stream_external_enc_idx(&state.stream));
+    state.converter = icu_converter_borrow(state.converter_name);
+    icu_uscratch_init(&state.input, (int32_t)state.stream.chunk_size + 16);
+    int text_allocated = transliterator_text_init(&state.text, TRANSLITERATOR_STREAM_SLICE_SIZE * 2);
+    int out_allocated = transliterator_text_init(&state.out, TRANSLITERATOR_STREAM_SLICE_SIZE * 2);
+    if (!text_allocated || !out_allocated) {
+        transliterator_stream_close(&state.stream);
+        rb_memerror();
+    }
 
-    return icu_ustring_to_rb_enc_str_with_len(u_str, len);
+    icu_stream_run(&state.stream);
+    return SIZET2NUM(state.stream.written);
 }
 
 VALUE transliterator_unicode_id(VALUE self)
@@ -149,11 +592,17 @@ void init_icu_transliterator(void)
     rb_define_alloc_func(rb_cICU_Transliterator, transliterator_alloc);
     rb_define_method(rb_cICU_Transliterator, "initialize", transliterator_initialize, -1);
     rb_define_method(rb_cICU_Transliterator, "transliterate", transliterator_transliterate, 1);
+    rb_define_method(rb_cICU_Transliterator, "transliterate_stream", transliterator_transliterate_stream, -1);
     rb_define_method(rb_cICU_Transliterator, "unicode_id", transliterator_unicode_id, 0);
 
     rb_define_module_function(rb_cICU_Transliterator, "available_ids", transliterator_available_ids, 0);
+    rb_define_module_function(rb_cICU_Transliterator, "cache_stats", transliterator_cache_stats, 0);
+    rb_define_module_function(rb_cICU_Transliterator, "clear_cache", transliterator_clear_cache, 0);
+    rb_define_module_function(rb_cICU_Transliterator, "cache_size=", transliterator_set_cache_size, 1);
 }
 
+#undef TRANSLITERATOR_CACHE_DEFAULT_SIZE
+#undef TRANSLITERATOR_STREAM_SLICE_SIZE
 #undef GET_TRANSLITERATOR
 
 /* vim: set expandtab sws=4 sw=4: */
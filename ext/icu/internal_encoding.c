@@ -1,8 +1,13 @@
 #include "icu.h"
+#include "unicode/ucnv.h"
+#include "ruby/util.h"
+#include <string.h>
 
 static rb_encoding* ascii_enc;
 static rb_encoding* utf8_enc;
 static ID ID_to_s;
+static UConverter** converters; // indexed by the Ruby encoding index
+static int converters_capa;
 
 int icu_is_rb_enc_idx_as_utf_8(int enc_idx)
 {
@@ -30,6 +35,85 @@ VALUE rb_str_enc_to_ascii_as_utf8(VALUE str)
     return str;
 }
 
+/*
+ Returns the converter of the encoding, it's opened once and shared afterwards.
+ The converter must be used with the GVL held and not across calls to Ruby,
+ so it never has state left from another user. Don't close it.
+*/
+UConverter* icu_converter_for_enc_idx(int enc_idx)
+{
+    if (enc_idx >= converters_capa) {
+        int capa = enc_idx + 16;
+        REALLOC_N(converters, UConverter*, capa);
+        memset(converters + converters_capa, 0, sizeof(UConverter*) * (capa - converters_capa));
+        converters_capa = capa;
+    }
+    if (converters[enc_idx] == NULL) {
+        UErrorCode status = U_ZERO_ERROR;
+        UConverter* converter = ucnv_open(ICU_RB_STRING_ENC_NAME_IDX(enc_idx), &status);
+        if (U_FAILURE(status)) {
+            icu_rb_raise_icu_error(status);
+        }
+        converters[enc_idx] = converter;
+    }
+    return converters[enc_idx];
+}
+
+/* The name of the ICU converter for the Ruby encoding. */
+const char* icu_converter_name_for_enc_idx(int enc_idx)
+{
+    return icu_is_rb_enc_idx_as_utf_8(enc_idx) ? "UTF-8" : ICU_RB_STRING_ENC_NAME_IDX(enc_idx);
+}
+
+/*
+ Streams keep a converter across calls to Ruby, so they can't use the shared ones above.
+ They borrow one by name and give it back when they are done, an idle converter is kept
+ for every name so a stream doesn't open new ones each time. Only names ICU opens are
+ kept. Only touched with the GVL held, the stream methods aren't marked Ractor safe.
+*/
+static st_table* idle_converters = NULL;
+
+UConverter* icu_converter_borrow(const char* name)
+{
+    st_data_t converter = 0;
+    if (idle_converters != NULL && st_lookup(idle_converters, (st_data_t)name, &converter) && converter != 0) {
+        st_insert(idle_converters, (st_data_t)name, 0); // the key stays, it's the copy made below
+        return (UConverter*)converter;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    UConverter* result = ucnv_open(name, &status);
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return result;
+}
+
+// resets the converter for the next borrower, including the callbacks it may have set
+void icu_converter_give_back(const char* name, UConverter* converter)
+{
+    if (converter == NULL) {
+        return;
+    }
+    if (idle_converters == NULL) {
+        idle_converters = st_init_strtable();
+    }
+    st_data_t idle = 0;
+    int known = st_lookup(idle_converters, (st_data_t)name, &idle);
+    if (idle != 0) { // another stream of the charset gave its converter back first
+        ucnv_close(converter);
+        return;
+    }
+    UErrorCode status = U_ZERO_ERROR;
+    ucnv_reset(converter);
+    ucnv_setToUCallBack(converter, UCNV_TO_U_CALLBACK_SUBSTITUTE, NULL, NULL, NULL, &status);
+    ucnv_setFromUCallBack(converter, UCNV_FROM_U_CALLBACK_SUBSTITUTE, NULL, NULL, NULL, &status);
+    if (U_FAILURE(status)) {
+        ucnv_close(converter);
+        return;
+    }
+    st_insert(idle_converters, known ? (st_data_t)name : (st_data_t)ruby_strdup(name), (st_data_t)converter);
+}
+
 void init_internal_encoding(void)
 {
     ascii_enc = rb_ascii8bit_encoding();
@@ -1,5 +1,6 @@
 #include "icu.h"
 #include "unicode/ucnv.h"
+#include <string.h>
 
 // #define ICU_USTRING_DEBUG 1
 
@@ -15,14 +16,13 @@ typedef struct {
     int32_t len;
     int32_t capa;
     int rb_enc_idx;
-    UConverter* converter;
+    UConverter* converter; // shared, see icu_converter_for_enc_idx
     UChar* ptr;
 } icu_ustring_data;
 
 static void icu_ustring_free(void* _this)
 {
     icu_ustring_data* this = _this;
-    ucnv_close(this->converter);
     if (this->ptr != NULL) {
         ruby_xfree(this->ptr);
     }
@@ -86,12 +86,10 @@ VALUE icu_ustring_from_rb_str(VALUE rb_str)
     if (icu_is_rb_enc_idx_as_utf_8(this->rb_enc_idx)) {
         this->converter = NULL;
     } else {
-        this->converter = ucnv_open(ICU_RB_STRING_ENC_NAME_IDX(this->rb_enc_idx), &status);
-        if (U_FAILURE(status)) {
-            icu_rb_raise_icu_error(status);
-        }
+        this->converter = icu_converter_for_enc_idx(this->rb_enc_idx);
     }
 
+    // no encoding needs more UTF-16 units than bytes, so this doesn't overflow
     this->capa = RSTRING_LENINT(rb_str) + RUBY_C_STRING_TERMINATOR_SIZE;
     this->ptr = ALLOC_N(UChar, this->capa);
 
@@ -114,6 +112,7 @@ VALUE icu_ustring_from_rb_str(VALUE rb_str)
         }
         if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
             retried = TRUE;
+            icu_count_retry(ICU_RETRY_USTRING_FROM_RB_STR);
             this->capa = len + RUBY_C_STRING_TERMINATOR_SIZE;
             REALLOC_N(this->ptr, UChar, this->capa);
             status = U_ZERO_ERROR;
@@ -167,20 +166,12 @@ VALUE icu_ustring_init_with_capa_enc(int32_t capa, int enc_idx)
 void icu_ustring_set_enc(VALUE self, int enc_idx)
 {
     GET_STRING(this);
-    if (this->converter != NULL) {
-        ucnv_close(this->converter);
-    }
-
     this->rb_enc_idx = enc_idx;
     // take UTF-8 code path
     if (icu_is_rb_enc_idx_as_utf_8(enc_idx)) {
         this->converter = NULL;
     } else {
-        UErrorCode status = U_ZERO_ERROR;
-        this->converter = ucnv_open(ICU_RB_STRING_ENC_NAME_IDX(this->rb_enc_idx), &status);
-        if (U_FAILURE(status)) {
-            icu_rb_raise_icu_error(status);
-        }
+        this->converter = icu_converter_for_enc_idx(enc_idx);
     }
 }
 
@@ -204,46 +195,123 @@ VALUE icu_ustring_to_rb_enc_str(VALUE self)
     }
 
 #ifdef ICU_USTRING_DEBUG
-    printf("icu_ustring_to_rb_enc_str: %p %d %d\n", self, this->len, this->capa);
+    printf("icu_ustring_to_rb_enc_str: %p %d %d %d\n", (void *)self, this->len, this->capa, this->rb_enc_idx);
 #endif
 
-    int32_t dest_len;
-    int32_t dest_capa = this->len + RUBY_C_STRING_TERMINATOR_SIZE;
-    char* dest = ALLOC_N(char, dest_capa);
-    int retried = FALSE;
+    VALUE rb_str = icu_uchar_to_rb_enc_str(this->ptr, this->len, this->rb_enc_idx);
+    OBJ_TAINT(rb_str);
+    return rb_str;
+}
+
+/*
+ Converts UChars straight into a new Ruby string of the encoding without an icu/ustring object.
+ The size of the result is pre-flighted so the Ruby string is allocated only once.
+*/
+VALUE icu_uchar_to_rb_enc_str(const UChar* ptr, int32_t len, int enc_idx)
+{
     UErrorCode status = U_ZERO_ERROR;
-    do {
-        if (this->converter == NULL) {
-            u_strToUTF8(dest, dest_capa, &dest_len, this->ptr, this->len, &status);
-        } else {
-            dest_len = ucnv_fromUChars(this->converter, dest, dest_capa,
-                                       this->ptr, this->len,
-                                       &status);
-        }
-        if (!retried && status == U_BUFFER_OVERFLOW_ERROR) {
-            retried = TRUE;
-            dest_capa = dest_len + RUBY_C_STRING_TERMINATOR_SIZE;
-            REALLOC_N(dest, char, dest_capa);
-            status = U_ZERO_ERROR;
-        } else if (U_FAILURE(status)) {
-            ruby_xfree(dest);
-            icu_rb_raise_icu_error(status);
-        } else { // retried == true && U_SUCCESS(status)
-            break;
-        }
-    } while (retried);
+    int32_t dest_len;
+    VALUE rb_str;
+    if (icu_is_rb_enc_idx_as_utf_8(enc_idx)) {
+        u_strToUTF8(NULL, 0, &dest_len, ptr, len, &status);
+        rb_str = rb_enc_str_new(NULL, dest_len, rb_enc_from_index(enc_idx));
+        status = U_ZERO_ERROR;
+        u_strToUTF8(RSTRING_PTR(rb_str), dest_len, &dest_len, ptr, len, &status);
+    } else {
+        UConverter* converter = icu_converter_for_enc_idx(enc_idx);
+        dest_len = ucnv_fromUChars(converter, NULL, 0, ptr, len, &status);
+        rb_str = rb_enc_str_new(NULL, dest_len, rb_enc_from_index(enc_idx));
+        status = U_ZERO_ERROR;
+        ucnv_fromUChars(converter, RSTRING_PTR(rb_str), dest_len, ptr, len, &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_rb_raise_icu_error(status);
+    }
+    return rb_str;
+}
 
-#ifdef ICU_USTRING_DEBUG
-    printf("icu_ustring_to_rb_enc_str (before creating rb str): %p %d %d %d\n", (void *)self, this->len, this->capa, this->rb_enc_idx);
-    printf("icu_ustring_to_rb_enc_str (pointers): %p %p %d\n", (void *)self, dest, dest_len);
-#endif
+/*
+ Converts a Ruby string into the UChar buffer without an icu/ustring object.
+ Returns the length of the result, or the length needed on U_BUFFER_OVERFLOW_ERROR.
+ A capacity of the byte length plus one is enough for UTF-8, a UTF-8 byte never
+ decodes to more than one unit. Converters of other charsets can map a byte
+ sequence to more units than it has bytes, so callers must handle the overflow.
+*/
+int32_t icu_rb_str_to_uchar(VALUE rb_str, UChar* dest, int32_t capa, UErrorCode* status)
+{
+    int32_t len;
+    int enc_idx = icu_rb_str_enc_idx(rb_str);
+    if (icu_is_rb_enc_idx_as_utf_8(enc_idx)) {
+        u_strFromUTF8(dest, capa, &len,
+                      RSTRING_PTR(rb_str), RSTRING_LENINT(rb_str),
+                      status);
+    } else {
+        len = ucnv_toUChars(icu_converter_for_enc_idx(enc_idx), dest, capa,
+                            RSTRING_PTR(rb_str), RSTRING_LENINT(rb_str),
+                            status);
+    }
+    return len;
+}
 
-    VALUE rb_str = rb_enc_str_new(dest, dest_len, rb_enc_from_index(this->rb_enc_idx));
-    ruby_xfree(dest);
-    OBJ_TAINT(rb_str);
-    return rb_str;
+void icu_uscratch_init(icu_uscratch* this, int32_t capa)
+{
+    this->len = 0;
+    this->heap = 0;
+    if (capa <= ICU_USCRATCH_INLINE_CAPA) {
+        this->ptr = this->inline_ptr;
+        this->capa = ICU_USCRATCH_INLINE_CAPA;
+    } else {
+        this->ptr = rb_alloc_tmp_buffer(&this->heap, sizeof(UChar) * capa);
+        this->capa = capa;
+    }
 }
 
+// keeps the first len units
+void icu_uscratch_resize(icu_uscratch* this, int32_t capa)
+{
+    if (capa <= this->capa) {
+        return;
+    }
+    VALUE heap = 0;
+    UChar* ptr = rb_alloc_tmp_buffer(&heap, sizeof(UChar) * capa);
+    memcpy(ptr, this->ptr, sizeof(UChar) * this->len);
+    if (this->heap != 0) {
+        rb_free_tmp_buffer(&this->heap);
+    }
+    this->heap = heap;
+    this->ptr = ptr;
+    this->capa = capa;
+}
+
+void icu_uscratch_free(icu_uscratch* this)
+{
+    if (this->heap != 0) {
+        rb_free_tmp_buffer(&this->heap);
+    }
+    this->ptr = this->inline_ptr;
+    this->capa = ICU_USCRATCH_INLINE_CAPA;
+    this->len = 0;
+}
+
+/* The stack counterpart of icu_ustring_from_rb_str. */
+void icu_uscratch_from_rb_str(icu_uscratch* this, VALUE rb_str)
+{
+    StringValue(rb_str);
+    icu_uscratch_init(this, RSTRING_LENINT(rb_str) + RUBY_C_STRING_TERMINATOR_SIZE);
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = icu_rb_str_to_uchar(rb_str, this->ptr, this->capa, &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        icu_count_retry(ICU_RETRY_USTRING_FROM_RB_STR);
+        icu_uscratch_resize(this, len + RUBY_C_STRING_TERMINATOR_SIZE);
+        status = U_ZERO_ERROR;
+        len = icu_rb_str_to_uchar(rb_str, this->ptr, this->capa, &status);
+    }
+    if (U_FAILURE(status)) {
+        icu_uscratch_free(this);
+        icu_rb_raise_icu_error(status);
+    }
+    this->len = len;
+}
 
 inline UChar* icu_ustring_ptr_internal(const icu_ustring_data *this)
 {
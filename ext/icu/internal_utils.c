@@ -1,5 +1,8 @@
 #include "icu.h"
 #include "unicode/utypes.h"
+#ifdef HAVE_RUBY_ATOMIC_H
+#include "ruby/atomic.h"
+#endif
 
 VALUE icu_enum_to_rb_ary(UEnumeration* icu_enum, UErrorCode status, long pre_allocated)
 {
@@ -49,3 +52,151 @@ extern inline void icu_rb_raise_icu_parse_error(const UParseError* error)
              error->line,
              error->offset);
 }
+
+/* Runs func without the GVL when the input size is large enough for other threads
+   to make progress. The data must not reference Ruby objects which can be modified
+   by other threads meanwhile. func can't be stopped halfway, interrupts such as
+   Thread#raise or Ctrl-C are handled as soon as it returns. */
+void* icu_call_without_gvl_when(long size, void* (*func)(void*), void* data)
+{
+    if (size < ICU_WITHOUT_GVL_THRESHOLD) {
+        return func(data);
+    }
+    return rb_thread_call_without_gvl(func, data, RUBY_UBF_IO, NULL);
+}
+
+static void icu_set_interrupted(void* interrupted)
+{
+    *(volatile int*)interrupted = TRUE;
+}
+
+/* Like icu_call_without_gvl_when for a func which works in segments. It checks
+   *interrupted between the segments and returns early when it's set, calling it
+   again resumes the work. The interrupts are handled in between, the ones which
+   raise stop the work there. */
+void icu_call_without_gvl_resumable_when(long size, void* (*func)(void*), void* data, volatile int* interrupted)
+{
+    *interrupted = FALSE;
+    if (size < ICU_WITHOUT_GVL_THRESHOLD) {
+        func(data);
+        return;
+    }
+    do {
+        *interrupted = FALSE;
+        rb_thread_call_without_gvl(func, data, icu_set_interrupted, (void*)interrupted);
+    } while (*interrupted);
+}
+
+static ID ID_read;
+static ID ID_write;
+static ID ID_external_encoding;
+
+/* Scans the (io_in, io_out, chunk_size = nil) arguments of a stream method. */
+void icu_stream_init(icu_stream* stream, int argc, VALUE* argv)
+{
+    VALUE chunk_size;
+    rb_scan_args(argc, argv, "21", &stream->io_in, &stream->io_out, &chunk_size);
+    stream->chunk_size = NIL_P(chunk_size) ? ICU_STREAM_CHUNK_SIZE : NUM2LONG(chunk_size);
+    if (stream->chunk_size <= 0 || stream->chunk_size > ICU_STREAM_MAX_CHUNK_SIZE) {
+        rb_raise(rb_eArgError, "chunk size must be between 1 and %d", ICU_STREAM_MAX_CHUNK_SIZE);
+    }
+    stream->written = 0;
+    stream->process = NULL;
+    stream->close = NULL;
+}
+
+/* Returns the index of the external encoding of io_in, UTF-8 when it has none. */
+int icu_stream_external_enc_idx(const icu_stream* stream)
+{
+    if (rb_respond_to(stream->io_in, ID_external_encoding)) {
+        VALUE enc = rb_funcall(stream->io_in, ID_external_encoding, 0);
+        if (!NIL_P(enc)) {
+            return rb_to_encoding_index(enc);
+        }
+    }
+    return rb_utf8_encindex();
+}
+
+void icu_stream_write(icu_stream* stream, VALUE str)
+{
+    if (RSTRING_LEN(str) > 0) {
+        rb_funcall(stream->io_out, ID_write, 1, str);
+        stream->written += RSTRING_LEN(str);
+    }
+}
+
+static VALUE icu_stream_read_all(VALUE _stream)
+{
+    icu_stream* stream = (icu_stream*)_stream;
+    VALUE chunk_size = LONG2NUM(stream->chunk_size);
+    VALUE buffer = rb_str_buf_new(stream->chunk_size); // reused by every read
+    VALUE chunk;
+    do {
+        chunk = rb_funcall(stream->io_in, ID_read, 2, chunk_size, buffer);
+        if (!NIL_P(chunk)) {
+            StringValue(chunk);
+        }
+        stream->process(stream, chunk);
+    } while (!NIL_P(chunk));
+    RB_GC_GUARD(buffer);
+    return Qnil;
+}
+
+static VALUE icu_stream_close(VALUE _stream)
+{
+    icu_stream* stream = (icu_stream*)_stream;
+    stream->close(stream);
+    return Qnil;
+}
+
+/* Reads io_in until its end and hands every chunk to process, then calls close. */
+void icu_stream_run(icu_stream* stream)
+{
+    rb_ensure(icu_stream_read_all, (VALUE)stream, icu_stream_close, (VALUE)stream);
+}
+
+static size_t retry_counts[ICU_RETRY_SITES];
+static const char* retry_site_names[ICU_RETRY_SITES] = {
+    "ustring_from_rb_str",
+    "normalize",
+    "skeleton",
+    "sort_key",
+};
+
+// spoof checks count from every Ractor, they don't share a GVL
+void icu_count_retry(icu_retry_site site)
+{
+#ifdef HAVE_RUBY_ATOMIC_H
+    RUBY_ATOMIC_SIZE_INC(retry_counts[site]);
+#else // no Ractors before Ruby 3.0, the GVL is enough
+    retry_counts[site]++;
+#endif
+}
+
+/* Returns how many times ICU calls ran again because the estimated buffer was too small. */
+VALUE icu_retry_counts(VALUE self)
+{
+    VALUE result = rb_hash_new();
+    for (int i = 0; i < ICU_RETRY_SITES; ++i) {
+        rb_hash_aset(result, ID2SYM(rb_intern(retry_site_names[i])), SIZET2NUM(retry_counts[i]));
+    }
+    return result;
+}
+
+VALUE icu_reset_retry_counts(VALUE self)
+{
+    for (int i = 0; i < ICU_RETRY_SITES; ++i) {
+        retry_counts[i] = 0;
+    }
+    return Qnil;
+}
+
+void init_internal_utils(void)
+{
+    ID_read = rb_intern("read");
+    ID_write = rb_intern("write");
+    ID_external_encoding = rb_intern("external_encoding");
+
+    rb_define_module_function(rb_mICU, "retry_counts", icu_retry_counts, 0);
+    rb_define_module_function(rb_mICU, "reset_retry_counts", icu_reset_retry_counts, 0);
+}
@@ -1,5 +1,76 @@
 module ICU
   class CharsetDetector
     alias input_filter_enabled? input_filter
+
+    IO_STRATEGIES = [:head, :tail, :strided].freeze
+    # :head starts with this many bytes and doubles them until it is confident
+    IO_HEAD_START_BYTES = 4096
+    # :strided spreads sample_bytes over this many windows, the first one at the head
+    IO_STRIDES = 4
+
+    # Detects the charset of io from at most sample_bytes bytes instead of all of it.
+    # :head reads the beginning, :tail the end and :strided windows spread over the io,
+    # the last two need an io which can seek and tell its size. Sampling stops early
+    # once a match reaches min_confidence, otherwise the most confident match wins.
+    def detect_io(io, sample_bytes: 65536, strategy: :head, min_confidence: 90)
+      raise ArgumentError, "sample_bytes must be positive" unless sample_bytes > 0
+
+      case strategy
+      when :head
+        detect_io_head(io, sample_bytes, min_confidence)
+      when :tail
+        detect_io_windows(io, sample_bytes, 1, min_confidence)
+      when :strided
+        detect_io_windows(io, [sample_bytes / IO_STRIDES, 1].max, IO_STRIDES, min_confidence)
+      else
+        raise ArgumentError, "unknown strategy #{strategy.inspect}, expected one of #{IO_STRATEGIES.inspect}"
+      end
+    end
+
+    private
+
+    def detect_io_head(io, sample_bytes, min_confidence)
+      sample = ''.b
+      chunk = ''.b
+      wanted = [IO_HEAD_START_BYTES, sample_bytes].min
+      loop do
+        missing = wanted - sample.bytesize
+        eof = io.read(missing, chunk).nil? || chunk.bytesize < missing
+        sample << chunk unless eof && chunk.empty?
+        match = detect(sample)
+        return match if eof || match.confidence >= min_confidence || wanted == sample_bytes
+        wanted = [wanted * 2, sample_bytes].min
+      end
+    end
+
+    def detect_io_windows(io, window_bytes, count, min_confidence)
+      size = io.size
+      if size <= window_bytes * count
+        io.seek(0)
+        return detect(io.read || ''.b)
+      end
+
+      best = nil
+      window = ''.b
+      count.times do |i|
+        # windows are spread evenly and the last one ends with the io
+        offset = count == 1 ? size - window_bytes : (size - window_bytes) * i / (count - 1)
+        # keeps UTF-16 and UTF-32 code units aligned
+        offset -= offset % 4
+        io.seek(offset)
+        io.read(window_bytes, window)
+        match = detect(offset.zero? ? window : detect_io_skip_continuation(window))
+        best = match if best.nil? || match.confidence > best.confidence
+        break if best.confidence >= min_confidence
+      end
+      best
+    end
+
+    # a window cut in the middle of a UTF-8 sequence would look like invalid UTF-8
+    def detect_io_skip_continuation(window)
+      skip = 0
+      skip += 1 while skip < 3 && skip < window.bytesize && (window.getbyte(skip) & 0xC0) == 0x80
+      skip.zero? ? window : window.byteslice(skip, window.bytesize - skip)
+    end
   end
-end
\ No newline at end of file
+end
@@ -1,14 +1,10 @@
 module ICU
   class Collator
     def self.sort(locale, strings)
-      self.new(locale)
+      self.for(locale)
           .sort(strings)
     end
 
-    def sort(strings)
-      strings.sort { |a, b| compare(a, b) }
-    end
-
     def greater?(str_a, str_b)
       compare(str_a, str_b) > 0
     end
@@ -1,6 +1,6 @@
 module ICU
   class Locale
-    attr_reader :id, :enc
+    attr_reader :enc
 
     def ==(other)
       other.is_a?(self.class) && other.id == self.id
@@ -9,6 +9,18 @@ module ICU
     alias === ==
     alias to_s id
 
+    def inspect
+      "#<#{self.class} #{id}>"
+    end
+
+    def marshal_dump
+      id
+    end
+
+    def marshal_load(id)
+      initialize(id)
+    end
+
     def with_keywords(keywords)
       keywords.reduce(self) do |locale, (keyword, value)|
         # p locale, keyword, value
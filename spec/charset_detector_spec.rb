@@ -1,6 +1,7 @@
 # encoding: UTF-8
 
 require 'spec_helper'
+require 'stringio'
 
 describe ICU::CharsetDetector do
   describe '.detect' do
@@ -19,6 +20,135 @@ describe ICU::CharsetDetector do
     end
   end
 
+  describe '.detect_name' do
+    it "returns the name of the best match" do
+      expect(subject.detect_name("æåø")).to eq "UTF-8"
+      expect(subject.detect_name("foo".encode("UTF-16").force_encoding("binary"))).to eq "UTF-16BE"
+    end
+
+    it "returns the same frozen name every time" do
+      name = subject.detect_name("æåø")
+      expect(name).to be_frozen
+      expect(subject.detect_name("øæå")).to equal(name)
+      expect(subject.detect("æøå").name).to equal(name)
+    end
+  end
+
+  describe '.detect_many' do
+    it "detects every string of the array" do
+      texts = ["æåø", "foo".encode("UTF-16").force_encoding("binary"), "æåø " * 10_000]
+      matches = subject.detect_many(texts)
+      expect(matches.map(&:name)).to eq ["UTF-8", "UTF-16BE", "UTF-8"]
+      expect(matches.first).to eq subject.detect("æåø")
+      expect(matches.first.language).to be_frozen
+    end
+
+    it "returns an empty array for an empty array" do
+      expect(subject.detect_many([])).to eq []
+    end
+
+    it "raises on elements which are not strings" do
+      expect { subject.detect_many(["foo", 1]) }.to raise_error(TypeError)
+    end
+  end
+
+  describe '.detect_io' do
+    let(:latin) { ("Une île déserte, ça coûte cher. " * 4_000).encode("ISO-8859-1").force_encoding("binary") }
+    let(:utf8) { ("plain ascii text " * 10_000 + "æåø €uro").force_encoding("binary") }
+
+    it "detects from the head of the io" do
+      expect(subject.detect_io(StringIO.new("æåø " * 10_000)).name).to eq "UTF-8"
+      expect(subject.detect_io(StringIO.new(latin), sample_bytes: 1024).name).to eq "ISO-8859-1"
+    end
+
+    it "reads no more than sample_bytes" do
+      io = StringIO.new(latin)
+      subject.detect_io(io, sample_bytes: 10_000)
+      expect(io.pos).to be <= 10_000
+    end
+
+    it "stops reading once it is confident" do
+      io = StringIO.new("æåø " * 10_000)
+      subject.detect_io(io, sample_bytes: 40_000)
+      expect(io.pos).to eq ICU::CharsetDetector::IO_HEAD_START_BYTES
+    end
+
+    it "detects from the tail and from strided windows" do
+      expect(subject.detect_io(StringIO.new(utf8), sample_bytes: 4096, strategy: :head).name).not_to eq "UTF-8"
+      expect(subject.detect_io(StringIO.new(utf8), sample_bytes: 4096, strategy: :tail).name).to eq "UTF-8"
+      expect(subject.detect_io(StringIO.new(utf8), sample_bytes: 4096, strategy: :strided).name).to eq "UTF-8"
+      expect(subject.detect_io(StringIO.new(latin), sample_bytes: 4096, strategy: :strided).name).to eq "ISO-8859-1"
+    end
+
+    it "detects small and empty ios" do
+      expect(subject.detect_io(StringIO.new("æåø"), strategy: :strided).name).to eq "UTF-8"
+      expect(subject.detect_io(StringIO.new(""), strategy: :tail)).to eq subject.detect("")
+      expect(subject.detect_io(StringIO.new("")).name).to eq subject.detect("").name
+    end
+
+    it "raises on unknown strategies" do
+      expect { subject.detect_io(StringIO.new("foo"), strategy: :middle) }.to raise_error(ArgumentError)
+      expect { subject.detect_io(StringIO.new("foo"), sample_bytes: 0) }.to raise_error(ArgumentError)
+    end
+  end
+
+  describe '.to_utf8' do
+    let(:text) { "Une île déserte, ça coûte cher. " * 100 }
+
+    it "converts the detected charset to UTF-8" do
+      result = subject.to_utf8(text.encode("ISO-8859-1").force_encoding("binary"))
+      expect(result.encoding).to eq Encoding::UTF_8
+      expect(result).to eq text
+      expect(subject.to_utf8(text)).to eq text
+    end
+
+    it "converts multibyte charsets" do
+      japanese = "日本語のテキストです。" * 100
+      expect(subject.to_utf8(japanese.encode("Shift_JIS").force_encoding("binary"))).to eq japanese
+    end
+
+    it "drops the byte order mark" do
+      expect(subject.to_utf8(text.encode("UTF-16").force_encoding("binary"))).to eq text
+      expect(subject.to_utf8("\uFEFF" + text)).to eq text
+    end
+
+    it "converts an empty string" do
+      expect(subject.to_utf8("")).to eq ""
+    end
+  end
+
+  describe '.to_utf8_stream' do
+    let(:text) { "Une île déserte, ça coûte cher. " * 1_000 }
+
+    it "writes the input converted to UTF-8 and returns the detected charset" do
+      out = StringIO.new
+      name = subject.to_utf8_stream(StringIO.new(text.encode("ISO-8859-1").force_encoding("binary")), out, 1000)
+      expect(name).to eq "ISO-8859-1"
+      expect(out.string.force_encoding("UTF-8")).to eq text
+    end
+
+    it "keeps characters split between chunks" do
+      out = StringIO.new
+      input = StringIO.new(text.encode("UTF-16").force_encoding("binary"))
+      expect(subject.to_utf8_stream(input, out, 999)).to eq "UTF-16BE"
+      expect(out.string.force_encoding("UTF-8")).to eq text
+    end
+
+    it "writes nothing for an empty input" do
+      out = StringIO.new
+      subject.to_utf8_stream(StringIO.new(""), out)
+      expect(out.string).to eq ""
+    end
+  end
+
+  describe 'detecting from several threads' do
+    it "returns the same result" do
+      text = "æåø " * 10_000
+      names = 4.times.map { Thread.new { subject.detect(text).name } }.map(&:value)
+      expect(names).to eq ["UTF-8"] * 4
+    end
+  end
+
   describe '.detect_all' do
     it "should detect several matching encodings" do
       expect(subject.detect_all("foo bar")).to be_instance_of(Array)
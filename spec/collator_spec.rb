@@ -8,6 +8,218 @@ describe ICU::Collator do
     it "should sort an array of strings" do
       expect(subject.sort(%w[å ø æ])).to eq %w[æ ø å]
     end
+
+    it "sorts strings in other encodings" do
+      expect(subject.sort(%w[å ø æ].map { |s| s.encode("UTF-16") })).to eq %w[æ ø å].map { |s| s.encode("UTF-16") }
+    end
+
+    it "keeps the order of equal strings" do
+      a = "a"
+      b = "a"
+      result = subject.sort([b, "b", a])
+      expect(result[0]).to be b
+      expect(result[1]).to be a
+    end
+  end
+
+  describe '.strength=' do
+    it "compares base letters only at the primary strength" do
+      expect(subject.strength).to eq :tertiary
+      subject.strength = :primary
+      expect(subject.strength).to eq :primary
+      expect(subject.compare("Resume", "résumé")).to eq 0
+      subject.case_level = true
+      expect(subject.case_level).to be_truthy
+      expect(subject.compare("Resume", "resume")).not_to eq 0
+      expect(subject.compare("resume", "résumé")).to eq 0
+    end
+
+    it "raises on unknown strengths" do
+      expect { subject.strength = :strongest }.to raise_error(ICU::InvalidParameterError)
+    end
+  end
+
+  describe '.alternate=' do
+    it "ignores punctuation when shifted" do
+      expect(subject.compare("di-ode", "diode")).not_to eq 0
+      subject.alternate = :shifted
+      subject.strength = :tertiary
+      expect(subject.alternate).to eq :shifted
+      expect(subject.compare("di-ode", "diode")).to eq 0
+      subject.max_variable = :space
+      expect(subject.max_variable).to eq :space
+      expect(subject.compare("di-ode", "diode")).not_to eq 0
+    end
+  end
+
+  describe '.numeric=' do
+    it "compares digits by their value" do
+      expect(subject.sort(%w[a10 a9])).to eq %w[a10 a9]
+      subject.numeric = true
+      expect(subject.numeric).to be_truthy
+      expect(subject.sort(%w[a10 a9])).to eq %w[a9 a10]
+    end
+  end
+
+  describe '.normalization=' do
+    it "toggles the normalization mode" do
+      subject.normalization = true
+      expect(subject.normalization).to be_truthy
+      expect(subject.compare("A\u030A", "\u00C5")).to eq 0
+    end
+  end
+
+  describe '#for' do
+    it "returns a frozen collator shared within a thread" do
+      collator = ICU::Collator.for(loc)
+      expect(collator).to be_frozen
+      expect(ICU::Collator.for(loc).object_id).to eq collator.object_id # Collator#equal? compares strings
+      expect(collator.sort(%w[å ø æ])).to eq %w[æ ø å]
+      expect { collator.strength = :primary }.to raise_error(FrozenError)
+    end
+
+    it "clones a collator for every thread" do
+      collator = ICU::Collator.for(loc)
+      other = Thread.new { ICU::Collator.for(loc) }.value
+      expect(other.object_id).not_to eq collator.object_id
+      expect(other.locale).to eq collator.locale
+    end
+
+    it "raises on invalid locales" do
+      expect { ICU::Collator.for("\xff" * 200) }.to raise_error(ICU::Error)
+    end
+
+    it "bounds the collators kept for unknown locales" do
+      collators = Array.new(200) { |i| ICU::Collator.for("zz-#{i}") }
+      expect(collators.last.locale).to eq ICU::Collator.for("zz-199").locale
+      expect(Thread.current[:__icu_collators__].size).to be <= 64
+      expect(ICU::Collator.for("nb_NO").sort(%w[å ø æ])).to eq %w[æ ø å]
+    end
+  end
+
+  describe '.bsearch_index' do
+    let(:sorted) { %w[a b c æ ø å] }
+
+    it "finds the first string which isn't less than the needle" do
+      sorted.each_with_index do |str, i|
+        expect(subject.bsearch_index(sorted, str)).to eq i
+      end
+      expect(subject.bsearch_index(sorted, "d")).to eq 3
+      expect(subject.bsearch_index(sorted, "B")).to eq 2
+      expect(subject.bsearch_index(sorted, "ø".encode("UTF-16"))).to eq 4
+    end
+
+    it "returns nil when every string is less" do
+      expect(subject.bsearch_index(sorted, "åå")).to eq nil
+      expect(subject.bsearch_index([], "a")).to eq nil
+    end
+
+    it "raises on non string elements" do
+      expect { subject.bsearch_index([1, 2], "a") }.to raise_error(TypeError)
+    end
+  end
+
+  describe '.merge' do
+    it "merges sorted arrays" do
+      expect(subject.merge(%w[a æ å], %w[b c ø])).to eq %w[a b c æ ø å]
+      expect(subject.merge([], %w[b c])).to eq %w[b c]
+      expect(subject.merge(%w[b c], [])).to eq %w[b c]
+    end
+
+    it "merges strings of other encodings" do
+      a = %w[a æ å].map { |str| str.encode("UTF-16LE") }
+      expect(subject.merge(a, %w[b c ø]).map { |str| str.encode("UTF-8") }).to eq %w[a b c æ ø å]
+    end
+
+    it "keeps the strings of the first array first on ties" do
+      a = "a"
+      b = "a"
+      result = subject.merge([a], [b])
+      expect(result[0]).to be a
+      expect(result[1]).to be b
+    end
+  end
+
+  describe '.hash_key' do
+    it "is the same for strings which compare equal" do
+      expect(subject.hash_key("Resume")).not_to eq subject.hash_key("résumé")
+      subject.strength = :primary
+      expect(subject.hash_key("Resume")).to eq subject.hash_key("résumé")
+      expect(subject.hash_key("Resume".encode("UTF-16"))).to eq subject.hash_key("résumé")
+      expect(subject.hash_key("Resume")).not_to eq subject.hash_key("Resumes")
+    end
+
+    it "hashes the whole key of long strings" do
+      long = "résumé " * 2000
+      expect(subject.hash_key(long)).to eq subject.hash_key(long.encode("UTF-16LE"))
+      expect(subject.hash_key(long)).not_to eq subject.hash_key(long + "a")
+    end
+  end
+
+  describe '.group_by' do
+    it "groups the strings which compare equal in the order of their first string" do
+      subject.strength = :primary
+      expect(subject.group_by(%w[résumé b Resume B a RESUME])).to eq [%w[résumé Resume RESUME], %w[b B], %w[a]]
+      expect(subject.group_by([])).to eq []
+    end
+
+    it "uses the configured strength" do
+      subject.strength = :secondary
+      expect(subject.group_by(%w[résumé Resume resume])).to eq [%w[résumé], %w[Resume resume]]
+    end
+  end
+
+  describe '.sort_key' do
+    it "returns a binary string" do
+      expect(subject.sort_key("blah").encoding).to eq Encoding::ASCII_8BIT
+    end
+
+    it "orders the keys the same as compare" do
+      expect(subject.sort_key("æ") < subject.sort_key("ø")).to be_truthy
+      expect(subject.sort_key("ø") < subject.sort_key("å")).to be_truthy
+      expect(subject.sort_key("blah".encode("UTF-16"))).to eq subject.sort_key("blah")
+    end
+
+    it "stops after the given levels" do
+      expect(subject.sort_key("Resume", levels: 1)).to eq subject.sort_key("résumé", levels: 1)
+      expect(subject.sort_key("Resume", levels: 2)).not_to eq subject.sort_key("résumé", levels: 2)
+      expect(subject.sort_key("blah", levels: 3)).to eq subject.sort_key("blah")
+      expect(subject.sort_key("blah".encode("UTF-16"), levels: 1)).to eq subject.sort_key("blah", levels: 1)
+    end
+
+    it "keeps the leading levels of a long key" do
+      text = "blåbærsyltetøy" * 100
+      key = subject.sort_key(text)
+      expect(subject.sort_key(text, levels: 1)).to eq key[0, key.index("\x01".b)]
+      expect(subject.sort_key(text, levels: 2)).to eq key[0, key.index("\x01".b, key.index("\x01".b) + 1)]
+    end
+
+    it "cuts the key after max_bytes" do
+      text = "blåbærsyltetøy" * 100
+      key = subject.sort_key(text)
+      expect(subject.sort_key(text, max_bytes: 16)).to eq key[0, 16]
+      expect(subject.sort_key("blah", max_bytes: 1000)).to eq subject.sort_key("blah")
+      expect(subject.sort_key(text, levels: 1, max_bytes: 0)).to be_empty
+    end
+  end
+
+  describe '.key_range' do
+    it "bounds the keys of strings starting with the prefix" do
+      lower, upper = subject.key_range("smi")
+      %w(smi Smith smithson Smil).each do |str|
+        key = subject.sort_key(str)
+        expect(key >= lower && key < upper).to be_truthy
+      end
+      %w(sma smo snow).each do |str|
+        key = subject.sort_key(str)
+        expect(key >= lower && key < upper).to be_falsey
+      end
+    end
+
+    it "takes more levels into account" do
+      lower, upper = subject.key_range("smi", levels: 3)
+      expect(subject.sort_key("Smith") >= lower && subject.sort_key("Smith") < upper).to be_falsey
+    end
   end
 
   describe '.compare' do
@@ -18,6 +230,7 @@ describe ICU::Collator do
       expect(subject.compare("blah", "blah")).to eq 0
       expect(subject.compare("blah".encode("UTF-16"), "blah".encode("UTF-32"))).to eq 0
       expect(subject.compare("ba", "bl")).to eq -1
+      expect(subject.compare(("blåbær" * 100).encode("UTF-16"), ("blåbær" * 100 + "a").encode("UTF-32"))).to eq -1
     end
   end
 
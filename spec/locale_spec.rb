@@ -309,4 +309,39 @@ describe ICU::Locale do
       end
     end
   end
+
+  context 'cached components' do
+    subject { ICU::Locale.new('zh_Hans_CH_PINYIN') }
+
+    it 'returns the same frozen string on every call' do
+      expect(subject.language).to be_frozen
+      expect(subject.language).to equal subject.language
+      expect(subject.base_name).to equal subject.base_name
+      expect(subject.language_tag).to equal subject.language_tag
+      expect(subject.id).to be_frozen
+    end
+
+    it "doesn't freeze the id it was created with" do
+      id = String.new('en_US')
+      ICU::Locale.new(id)
+      expect(id).not_to be_frozen
+    end
+
+    it 'parses ids longer than the stack buffer' do
+      id = 'en_US_' + Array.new(20, 'POSIXVARIANT').join('_')
+      expect(ICU::Locale.new(id).name).to eq id
+    end
+
+    it 'is kept by copies' do
+      subject.language
+      copy = subject.dup
+      expect(copy).to eq subject
+      expect(copy.language).to equal subject.language
+      expect(copy.variant).to eq 'PINYIN'
+    end
+
+    it 'can be marshaled' do
+      expect(Marshal.load(Marshal.dump(subject))).to eq subject
+    end
+  end
 end
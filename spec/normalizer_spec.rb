@@ -14,6 +14,34 @@ describe ICU::Normalizer do
       end
 
       it_should_behave_like "normalization example", %w(UTF-8 UTF-16 UTF-32 ISO-8859-1)
+
+      it "normalizes strings of legacy encodings alternately" do
+        sjis = "東京".encode("Shift_JIS")
+        eucjp = "渋谷".encode("EUC-JP")
+        3.times do
+          expect(subject.normalize(sjis)).to eq "東京"
+          expect(subject.normalize(eucjp)).to eq "渋谷"
+        end
+      end
+
+      it "normalizes empty and expanding UTF-8 strings" do
+        expect(subject.normalize("")).to eq ""
+        expect(subject.normalize("\u0958" * 3).unpack("U*")).to eq [0x915, 0x93C] * 3
+      end
+
+      it "normalizes large strings from several threads" do
+        text = "Å" * 100_000
+        results = 4.times.map { Thread.new { subject.normalize(text) } }.map(&:value)
+        expect(results.uniq.size).to eq 1
+        expect(results.first.unpack("U*")).to eq [65, 778] * 100_000
+      end
+
+      it "normalizes long expanding strings by segments and counts the retries" do
+        text = "한" * 10_000 + "e\u0301Å" * 1_000
+        ICU.reset_retry_counts
+        expect(subject.normalize(text)).to eq text.unicode_normalize(:nfd)
+        expect(ICU.retry_counts[:normalize]).to be > 0
+      end
     end
   end
 
@@ -30,6 +58,98 @@ describe ICU::Normalizer do
       end
 
       it_should_behave_like "normalization example", %w(UTF-8 UTF-16 UTF-32 ISO-8859-1)
+
+      it "returns an already normalized string unchanged" do
+        str = "Å".unicode_normalize(:nfc).freeze
+        expect(subject.normalize(str)).to be str
+        mutable = str.dup
+        expect(subject.normalize(mutable)).to be mutable
+        expect(subject.normalize(str.encode("UTF-16"))).to eq str
+      end
+
+      it "checks long strings piece by piece" do
+        normalized = ("Å" + "e\u0301".unicode_normalize(:nfc) + "abc" * 300 + "\u0301").unicode_normalize(:nfc)
+        expect(subject.normalize(normalized)).to be normalized
+        # the combining mark is far past the first piece of the check
+        decomposed = "abc" * 300 + "e\u0301"
+        expect(subject.normalize(decomposed)).to eq decomposed.unicode_normalize(:nfc)
+        marks = "a" + "\u0301" * 2000
+        expect(subject.normalize(marks)).to eq marks.unicode_normalize(:nfc)
+      end
+    end
+
+    describe '.normalize_all' do
+      it "normalizes every string" do
+        strs = ["Å", "abc", "Å".encode("UTF-16"), "", "Åffin" * 100]
+        expect(subject.normalize_all(strs)).to eq strs.map { |s| subject.normalize(s) }
+        expect(subject.normalize_all(strs, without_gvl: true)).to eq strs.map { |s| subject.normalize(s) }
+      end
+
+      it "takes the GVL switch only as a keyword" do
+        expect { subject.normalize_all(["a"], true) }.to raise_error(ArgumentError)
+        expect { subject.normalize_all(["a"], with_gvl: true) }.to raise_error(ArgumentError)
+      end
+
+      it "returns an empty array for an empty array" do
+        expect(subject.normalize_all([])).to eq []
+      end
+    end
+
+    describe '.normalize_stream' do
+      require 'stringio'
+
+      it "normalizes the stream by chunks" do
+        text = "Åffin ḳ́ \u0958 " * 1000
+        out = StringIO.new
+        written = subject.normalize_stream(StringIO.new(text), out, 7)
+        expect(out.string).to eq subject.normalize(text)
+        expect(written).to eq out.string.bytesize
+      end
+
+      it "decodes the stream as its external encoding" do
+        text = "Åffin " * 100
+        out = StringIO.new
+        subject.normalize_stream(StringIO.new(text.encode("UTF-16LE")), out, 5)
+        expect(out.string.force_encoding("UTF-8")).to eq subject.normalize(text)
+      end
+
+      it "composes characters split across chunks" do
+        out = StringIO.new
+        subject.normalize_stream(StringIO.new("A\u030A" * 100), out, 1)
+        expect(out.string.unpack("U*")).to eq [197] * 100
+      end
+
+      it "raises on invalid input as normalize does" do
+        invalid = "abc\xFFdef".b.force_encoding("UTF-8")
+        expect { subject.normalize(invalid) }.to raise_error(ICU::Error)
+        expect { subject.normalize_stream(StringIO.new(invalid), StringIO.new, 2) }.to raise_error(ICU::Error)
+      end
+
+      it "raises on chunk sizes outside of the int32_t lengths of ICU" do
+        expect { subject.normalize_stream(StringIO.new("a"), StringIO.new, 0) }.to raise_error(ArgumentError)
+        expect { subject.normalize_stream(StringIO.new("a"), StringIO.new, 2**31) }.to raise_error(ArgumentError)
+      end
+
+      it "bounds the text held back without a normalization boundary" do
+        marks = "a" + "\u0301" * (65536 * 16)
+        expect { subject.normalize_stream(StringIO.new(marks), StringIO.new) }.to raise_error(ICU::Error)
+      end
+    end
+
+    describe '.normalized?' do
+      it "tells whether the string is normalized" do
+        expect(subject.normalized?("\u00C5")).to be_truthy
+        expect(subject.normalized?("A\u030A")).to be_falsey
+        expect(subject.normalized?("A\u030A".encode("UTF-16"))).to be_falsey
+      end
+    end
+
+    describe '.quick_check' do
+      it "returns the check result" do
+        expect(subject.quick_check("abc")).to eq :yes
+        expect(subject.quick_check("\u212B")).to eq :no
+        expect(subject.quick_check("A\u030A")).to eq :maybe
+      end
     end
   end
 end
@@ -1,4 +1,5 @@
 require 'spec_helper'
+require 'tmpdir'
 
 describe ICU::SpoofChecker do
   let(:checker) { ICU::SpoofChecker.new }
@@ -49,6 +50,41 @@ describe ICU::SpoofChecker do
     end
   end
 
+  describe '.check_details' do
+    let(:levels) { ICU::SpoofChecker.available_restriction_levels }
+
+    it 'returns the checks with the restriction level and the numerics' do
+      result = checker.check_details('sсcs')
+      expect(result.checks).to eq checker.check('sсcs')
+      expect(result.restriction_level).to eq levels[:minimally_restrictive]
+      expect(result.numerics).to eq []
+    end
+
+    it 'returns the zero digits of the numbering systems found' do
+      result = checker.check_details('abc123٣')
+      expect(result.checks & ICU::SpoofChecker.available_checks[:mixed_numbers]).not_to eq 0
+      expect(result.numerics).to eq %w(0 ٠)
+      expect(checker.check_details('paypal'.encode('UTF-16')).restriction_level).to eq levels[:ascii]
+    end
+
+    it 'leaves out what the enabled checks do not compute' do
+      checker.checks = ICU::SpoofChecker.available_checks[:invisible]
+      result = checker.check_details('abc')
+      expect(result.checks).to eq 0
+      expect(result.restriction_level).to be_nil
+      expect(result.numerics).to be_nil
+    end
+  end
+
+  describe '.check_all' do
+    it 'returns the check result of every string' do
+      strings = ['abc', 'sсcs', 'abc123٣'.encode('UTF-16')]
+      expect(checker.check_all(strings)).to eq strings.map { |str| checker.check(str) }
+      expect(checker.check_all([])).to eq []
+      expect { checker.check_all(['abc', nil]) }.to raise_error(TypeError)
+    end
+  end
+
   describe '.get_skeleton' do
     it 'can gets the skeleton representation' do
       expect(checker.get_skeleton("𝔭𝒶ỿ𝕡𝕒ℓ")).not_to be_empty
@@ -60,4 +96,164 @@ describe ICU::SpoofChecker do
       expect(checker.get_skeleton("𝔭𝒶ỿ𝕡𝕒ℓ") == checker.get_skeleton("paypal")).to be_truthy
     end
   end
+
+  describe 'UTF-8 strings' do
+    let(:strings) { ["𝔭𝒶ỿ𝕡𝕒ℓ", "paypal", "sсcs", "abc123٣", "⑽" * 20, ""] }
+
+    it 'gets the same skeletons as other encodings' do
+      strings.each do |str|
+        expect(checker.get_skeleton(str)).to eq checker.get_skeleton(str.encode("UTF-16"))
+        expect(checker.get_skeleton(str)).to eq checker.get_skeleton(str.encode("UTF-32LE"))
+        expect(checker.get_skeleton(str).encoding).to eq Encoding::UTF_8
+      end
+      expect(checker.get_skeleton("⑽" * 20)).to eq "(lO)" * 20
+    end
+
+    it 'finds the same confusables as other encodings' do
+      strings.product(strings).each do |a, b|
+        expected = checker.confusable?(a.encode("UTF-16"), b.encode("UTF-16"))
+        expect(checker.confusable?(a, b)).to eq expected
+        expect(checker.confusable?(a, b.encode("UTF-16LE"))).to eq expected
+      end
+    end
+
+    it 'gets the same check results as other encodings' do
+      strings.each do |str|
+        expect(checker.check(str)).to eq checker.check(str.encode("UTF-16"))
+        expect(checker.check_details(str).checks).to eq checker.check_details(str.encode("UTF-16")).checks
+        expect(checker.check_details(str).numerics).to eq checker.check_details(str.encode("UTF-16")).numerics
+      end
+      expect(checker.check_all(strings)).to eq checker.check_all(strings.map { |str| str.encode("UTF-16") })
+    end
+  end
+
+  describe '.allowed_locales' do
+    it 'limits the characters to the scripts of the locales' do
+      checker.allowed_locales = %w(en ru)
+      expect(checker.allowed_locales).to eq "en,ru"
+      expect(checker.check("пример") & ICU::SpoofChecker.available_checks[:char_limit]).to eq 0
+      expect(checker.check("例") & ICU::SpoofChecker.available_checks[:char_limit]).not_to eq 0
+    end
+  end
+
+  describe '.profile' do
+    let(:checks) { ICU::SpoofChecker.available_checks[:restriction_level] | ICU::SpoofChecker.available_checks[:mixed_numbers] }
+    let(:level) { ICU::SpoofChecker.available_restriction_levels[:highly_restrictive] }
+    let!(:profile) { ICU::SpoofChecker.profile(:spec_username, checks: checks, level: level, allowed_locales: "en") }
+
+    it 'returns a frozen checker configured by the profile' do
+      expect(profile).to be_frozen
+      expect(profile.checks & checks).to eq checks
+      expect(profile.restriction_level).to eq level
+      expect(profile.allowed_locales).to eq "en"
+      expect { profile.checks = checks }.to raise_error(FrozenError)
+      expect { profile.allowed_locales = "ru" }.to raise_error(FrozenError)
+    end
+
+    it 'returns one checker per thread' do
+      expect(ICU::SpoofChecker.profile(:spec_username)).to equal profile
+      other = Thread.new { ICU::SpoofChecker.profile(:spec_username) }.value
+      expect(other).not_to equal profile
+      expect(other.check("user٣3")).to eq profile.check("user٣3")
+    end
+
+    it 'drops the clone of a redefined profile' do
+      old = ICU::SpoofChecker.profile(:spec_redefined, level: level)
+      checker = ICU::SpoofChecker.profile(:spec_redefined, checks: checks)
+      expect(checker).not_to equal old
+      expect(ICU::SpoofChecker.profile(:spec_redefined)).to equal checker
+      expect(Thread.current[:__icu_spoof_checkers__].values.map(&:last)).not_to include old
+    end
+
+    it 'keeps the profile when it is defined again with the same options' do
+      locales = "en"
+      again = ICU::SpoofChecker.profile(:spec_username, checks: checks, level: level, allowed_locales: locales)
+      expect(again).to equal profile
+      locales << ", ru"
+      expect(ICU::SpoofChecker.profile(:spec_username, checks: checks, level: level, allowed_locales: "en")).to equal profile
+    end
+
+    it 'raises on undefined profiles' do
+      expect { ICU::SpoofChecker.profile(:spec_undefined) }.to raise_error(ArgumentError)
+    end
+
+    if defined?(Ractor)
+      it 'can be shared with other Ractors' do
+        expect(Ractor.shareable?(profile)).to be_truthy
+        skeleton = Ractor.new(profile) { |checker| checker.get_skeleton("𝔭𝒶ỿ𝕡𝕒ℓ".encode("UTF-16LE")) }.take
+        expect(skeleton).to eq profile.get_skeleton("paypal")
+      end
+    end
+  end
+end
+
+describe ICU::SpoofChecker::SkeletonIndex do
+  let(:index) { ICU::SpoofChecker::SkeletonIndex.build(%w(paypal google apple paypa1)) }
+
+  describe '.lookup' do
+    it 'returns the names confusable with the string in the order they were added' do
+      expect(index.lookup("𝔭𝒶ỿ𝕡𝕒ℓ")).to eq %w(paypal paypa1)
+      expect(index.lookup("аррlе")).to eq %w(apple)
+      expect(index.lookup("banana")).to eq []
+    end
+
+    it 'looks up strings of other encodings' do
+      expect(index.lookup("ρ⍺у𝓅𝒂ן".encode("UTF-16"))).to eq %w(paypal paypa1)
+      expect(index.lookup("ρ⍺у𝓅𝒂ן".encode("UTF-16")).map(&:encoding).uniq).to eq [Encoding::UTF_8]
+    end
+
+    it 'agrees with the skeletons of the checker' do
+      checker = ICU::SpoofChecker.new
+      names = 500.times.map { |i| "user#{i}" }
+      big = ICU::SpoofChecker::SkeletonIndex.build(names, checker)
+      expect(big.lookup("usеr1O")).to eq names.select { |name| checker.get_skeleton(name) == checker.get_skeleton("usеr1O") }
+    end
+  end
+
+  describe '.add' do
+    it 'adds names once' do
+      index << "ρ⍺у𝓅𝒂ן" << "paypal"
+      expect(index.add("apple").size).to eq 5
+      expect(index.lookup("paypal")).to eq %w(paypal paypa1 ρ⍺у𝓅𝒂ן)
+    end
+
+    it 'adds arrays of names' do
+      expect(index.concat(%w(g00gle gooogle)).size).to eq 6
+      expect(index.lookup("g00gle")).to eq %w(g00gle)
+    end
+
+    it 'starts empty' do
+      empty = ICU::SpoofChecker::SkeletonIndex.new
+      expect(empty.size).to eq 0
+      expect(empty.lookup("paypal")).to eq []
+      expect(empty.confusable?("paypal")).to be_falsey
+    end
+  end
+
+  describe '.confusable?' do
+    it 'tells whether any name is confusable with the string' do
+      expect(index.confusable?("gооgle")).to be_truthy
+      expect(index.confusable?("banana")).to be_falsey
+    end
+  end
+
+  describe '.save and .load' do
+    let(:path) { File.join(Dir.tmpdir, "skeleton_index_#{Process.pid}.bin") }
+    after { File.delete(path) if File.exist?(path) }
+
+    it 'reads back the saved index' do
+      index.save(path)
+      loaded = ICU::SpoofChecker::SkeletonIndex.load(path)
+      expect(loaded.size).to eq index.size
+      expect(loaded.lookup("𝔭𝒶ỿ𝕡𝕒ℓ")).to eq %w(paypal paypa1)
+      loaded << "paypaI"
+      expect(loaded.lookup("paypal")).to eq %w(paypal paypa1 paypaI)
+    end
+
+    it 'raises on files which are not indexes' do
+      File.binwrite(path, "not an index" * 10)
+      expect { ICU::SpoofChecker::SkeletonIndex.load(path) }.to raise_error(ICU::Error)
+      expect { ICU::SpoofChecker::SkeletonIndex.load(path + ".missing") }.to raise_error(SystemCallError)
+    end
+  end
 end
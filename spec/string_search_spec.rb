@@ -0,0 +1,47 @@
+require 'spec_helper'
+
+describe ICU::StringSearch do
+  let(:collator) { ICU::Collator.new("en").tap { |c| c.strength = :primary } }
+  subject { ICU::StringSearch.new("resume", collator) }
+
+  describe '.each_match' do
+    it "yields the offsets and lengths of accent and case insensitive matches" do
+      text = "Mon résumé, son Resume et ton RÉSUMÉ."
+      matches = subject.each_match(text).to_a
+      expect(matches).to eq [[4, 6], [16, 6], [30, 6]]
+      expect(matches.map { |offset, len| text[offset, len] }).to eq %w(résumé Resume RÉSUMÉ)
+    end
+
+    it "reuses the pattern for many texts" do
+      expect(subject.each_match("resume").to_a).to eq [[0, 6]]
+      expect(subject.each_match("").to_a).to eq []
+      expect(subject.each_match("nothing here").to_a).to eq []
+      expect(subject.each_match("😀 résumé".encode("UTF-16")).to_a).to eq [[2, 6]]
+    end
+
+    it "follows changes of the collator strength" do
+      expect(subject.each_match("Résumé").to_a).to eq [[0, 6]]
+      collator.strength = :tertiary
+      expect(subject.each_match("Résumé").to_a).to eq []
+    end
+
+    it "can search again from the block" do
+      nested = []
+      subject.each_match("resume, Résumé") { |offset, _| nested << subject.each_match("x resume").to_a }
+      expect(nested).to eq [[[2, 6]], [[2, 6]]]
+    end
+  end
+
+  describe '.new' do
+    it "takes a locale name" do
+      search = ICU::StringSearch.new("straße", "de")
+      expect(search.each_match("Straße, die straße").to_a).to eq [[12, 6]]
+      expect(search.pattern).to eq "straße"
+      expect(search.collator).to be_a(ICU::Collator)
+    end
+
+    it "raises on an empty pattern" do
+      expect { ICU::StringSearch.new("", collator) }.to raise_error(ICU::InvalidParameterError)
+    end
+  end
+end
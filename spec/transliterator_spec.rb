@@ -17,6 +17,85 @@ describe ICU::Transliterator do
         expect(tl.transliterate(input)).to eq output
       end
     end
+
+    it "transliterates long expanding strings" do
+      input = "abcde" * 10_000
+      expect(transliterator_for("Any-Hex").transliterate(input)).to eq "\\u0061\\u0062\\u0063\\u0064\\u0065" * 10_000
+      expect(transliterator_for("Any-Hex/Unicode").transliterate("\u{1F600}")).to eq "U+1F600"
+    end
+  end
+
+  describe ".transliterate_stream" do
+    require 'stringio'
+
+    it "transliterates the stream by chunks" do
+      text = "Ελληνικά 雙屬性集合 दौलत " * 500
+      tl = transliterator_for("Any-Latin; Latin-ASCII")
+      out = StringIO.new
+      written = tl.transliterate_stream(StringIO.new(text), out, 7)
+      expect(out.string).to eq tl.transliterate(text)
+      expect(written).to eq out.string.bytesize
+    end
+
+    it "keeps the context across chunks" do
+      tl = transliterator_for("Any-Hex", "a } b > X;")
+      out = StringIO.new
+      tl.transliterate_stream(StringIO.new("ab" * 100), out, 1)
+      expect(out.string).to eq "Xb" * 100
+    end
+
+    it "keeps the context of rules looking back far" do
+      tl = transliterator_for("Any-Hex", "#{'q' * 600} { x > y;")
+      text = ("q" * 650 + "x ") * 10 + ("q" * 300 + "x ") * 5
+      out = StringIO.new
+      tl.transliterate_stream(StringIO.new(text), out, 64)
+      expect(out.string).to eq tl.transliterate(text)
+      expect(out.string.count("y")).to eq 10
+    end
+
+    it "decodes the stream as its external encoding" do
+      text = "Ελληνικά " * 100
+      tl = transliterator_for("Greek-Latin")
+      out = StringIO.new
+      tl.transliterate_stream(StringIO.new(text.encode("UTF-16LE")), out, 5)
+      expect(out.string.force_encoding("UTF-8")).to eq tl.transliterate(text)
+    end
+
+    it "raises on chunk sizes outside of the int32_t lengths of ICU" do
+      tl = transliterator_for("Greek-Latin")
+      expect { tl.transliterate_stream(StringIO.new("a"), StringIO.new, 0) }.to raise_error(ArgumentError)
+      expect { tl.transliterate_stream(StringIO.new("a"), StringIO.new, 2**31) }.to raise_error(ArgumentError)
+    end
+  end
+
+  describe '#cache_stats' do
+    subject { ICU::Transliterator }
+
+    after { subject.cache_size = 32 }
+
+    it "clones cached transliterators" do
+      subject.clear_cache
+      3.times { expect(subject.transliterate("Any-Latin; Latin-ASCII", "Ελληνικά")).to eq "Ellenika" }
+      expect(subject.cache_stats).to eq(hits: 2, misses: 1, size: 1, capacity: 32)
+    end
+
+    it "keys the cache by id, rules and direction" do
+      subject.clear_cache
+      expect(transliterator_for("Any-Hex").transliterate("a")).to eq "\\u0061"
+      expect(transliterator_for("Any-Hex", nil, :reverse).transliterate("\\u0061")).to eq "a"
+      expect(transliterator_for("Any-Hex", "a > b;").transliterate("a")).to eq "b"
+      expect(subject.cache_stats[:misses]).to eq 3
+    end
+
+    it "evicts the least recently used transliterator" do
+      subject.clear_cache
+      subject.cache_size = 2
+      %w(Lower Upper Lower Any-Hex Lower).each { |id| transliterator_for(id) }
+      expect(subject.cache_stats).to include(hits: 2, misses: 3, size: 2)
+      subject.cache_size = 0
+      expect(subject.cache_stats[:size]).to eq 0
+      expect(transliterator_for("Lower").transliterate("ABC")).to eq "abc"
+    end
   end
 
   describe '#available_ids' do